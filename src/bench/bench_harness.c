@@ -0,0 +1,283 @@
+/**
+ * @file bench_harness.c
+ * @brief Implementation of the shared microbenchmark harness
+ */
+
+#define _DEFAULT_SOURCE
+#include "bench_harness.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+long long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void bench_samples_init(BenchSamples *samples) {
+    samples->values = NULL;
+    samples->count = 0;
+    samples->capacity = 0;
+}
+
+void bench_samples_free(BenchSamples *samples) {
+    free(samples->values);
+    bench_samples_init(samples);
+}
+
+static bool samples_reserve(BenchSamples *samples, size_t needed) {
+    if (needed <= samples->capacity) {
+        return true;
+    }
+
+    size_t capacity = samples->capacity ? samples->capacity : 1024;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    long long *values = realloc(samples->values, capacity * sizeof(long long));
+    if (values == NULL) {
+        return false;
+    }
+
+    samples->values = values;
+    samples->capacity = capacity;
+    return true;
+}
+
+void bench_samples_add(BenchSamples *samples, long long ns) {
+    if (samples_reserve(samples, samples->count + 1)) {
+        samples->values[samples->count++] = ns;
+    }
+}
+
+void bench_samples_append(BenchSamples *dst, BenchSamples *src) {
+    if (src->count > 0 && samples_reserve(dst, dst->count + src->count)) {
+        memcpy(dst->values + dst->count, src->values, src->count * sizeof(long long));
+        dst->count += src->count;
+    }
+    src->count = 0;
+}
+
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted array
+static long long percentile(const long long *sorted, size_t count, double p) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t rank = (size_t)(p * count);
+    return sorted[rank < count ? rank : count - 1];
+}
+
+int bench_parse_args(BenchConfig *config, int argc, char *argv[]) {
+    config->warmup = BENCH_DEFAULT_WARMUP;
+    config->reps = BENCH_DEFAULT_REPS;
+    config->quick = false;
+    config->output_dir = BENCH_DEFAULT_OUTPUT_DIR;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            config->quick = true;
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            config->warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            config->reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            config->output_dir = argv[++i];
+        }
+    }
+
+    if (config->warmup < 0 || config->reps <= 0) {
+        fprintf(stderr, "Usage: %s [--warmup N] [--reps N] [--quick] [--output DIR]\n", argv[0]);
+        return -1;
+    }
+
+    return 0;
+}
+
+void bench_report_init(BenchReport *report, const char *suite, const BenchConfig *config) {
+    report->suite = suite;
+    report->config = *config;
+    report->results = NULL;
+    report->count = 0;
+    report->capacity = 0;
+
+    printf("\n[%s] warmup=%d reps=%d%s\n", suite, config->warmup, config->reps,
+           config->quick ? " (quick)" : "");
+    printf("%-16s %7s %8s %7s %12s %10s %10s %10s\n",
+           "scenario", "threads", "capacity", "payload", "ops/s", "p50 ns", "p99 ns", "p999 ns");
+}
+
+static int record_result(BenchReport *report, const BenchResult *result) {
+    if (report->count == report->capacity) {
+        size_t capacity = report->capacity ? report->capacity * 2 : 16;
+        BenchResult *results = realloc(report->results, capacity * sizeof(BenchResult));
+        if (results == NULL) {
+            return -1;
+        }
+        report->results = results;
+        report->capacity = capacity;
+    }
+
+    report->results[report->count++] = *result;
+    return 0;
+}
+
+int bench_run(BenchReport *report, const BenchCase *bench_case, BenchFn fn, void *ctx) {
+    int reps = report->config.reps;
+    double *rates = malloc(reps * sizeof(double));
+    if (rates == NULL) {
+        return -1;
+    }
+
+    BenchSamples samples;
+    bench_samples_init(&samples);
+    BenchRun run = {0, 0.0, &samples};
+
+    // Warmup repetitions settle caches, allocators and thread stacks
+    for (int i = 0; i < report->config.warmup; i++) {
+        if (fn(ctx, &run) != 0) {
+            goto fail;
+        }
+        samples.count = 0;
+    }
+
+    for (int i = 0; i < reps; i++) {
+        run.ops = 0;
+        run.seconds = 0.0;
+        if (fn(ctx, &run) != 0) {
+            goto fail;
+        }
+        rates[i] = run.seconds > 0 ? run.ops / run.seconds : 0.0;
+    }
+
+    qsort(rates, reps, sizeof(double), compare_double);
+    qsort(samples.values, samples.count, sizeof(long long), compare_ll);
+
+    BenchResult result;
+    result.bench_case = *bench_case;
+    result.reps = reps;
+    result.ops = run.ops;
+    result.ops_per_sec = rates[reps / 2];
+    result.ops_per_sec_min = rates[0];
+    result.ops_per_sec_max = rates[reps - 1];
+    result.p50_ns = percentile(samples.values, samples.count, 0.50);
+    result.p99_ns = percentile(samples.values, samples.count, 0.99);
+    result.p999_ns = percentile(samples.values, samples.count, 0.999);
+    result.samples = samples.count;
+
+    printf("%-16s %7d %8d %7d %12.0f %10lld %10lld %10lld\n",
+           bench_case->scenario, bench_case->threads, bench_case->capacity,
+           bench_case->payload, result.ops_per_sec,
+           result.p50_ns, result.p99_ns, result.p999_ns);
+    fflush(stdout);
+
+    free(rates);
+    bench_samples_free(&samples);
+    return record_result(report, &result);
+
+fail:
+    fprintf(stderr, "Scenario %s failed\n", bench_case->scenario);
+    free(rates);
+    bench_samples_free(&samples);
+    return -1;
+}
+
+static FILE *open_output(const BenchReport *report, const char *ext) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s_bench.%s", report->config.output_dir, report->suite, ext);
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+    }
+    return f;
+}
+
+int bench_report_finish(BenchReport *report) {
+    // Set by `make bench` so results can be matched to the commit they measure
+    const char *commit = getenv("BENCH_COMMIT");
+    if (commit == NULL) {
+        commit = "";
+    }
+
+    if (mkdir(report->config.output_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s: %s\n", report->config.output_dir, strerror(errno));
+    }
+
+    int status = 0;
+    FILE *csv = open_output(report, "csv");
+    FILE *json = open_output(report, "json");
+
+    if (csv != NULL) {
+        fprintf(csv, "suite,scenario,threads,capacity,payload,reps,ops,"
+                     "ops_per_sec,ops_per_sec_min,ops_per_sec_max,"
+                     "p50_ns,p99_ns,p999_ns,samples,commit\n");
+    }
+    if (json != NULL) {
+        fprintf(json, "[\n");
+    }
+
+    for (size_t i = 0; i < report->count; i++) {
+        const BenchResult *r = &report->results[i];
+        const BenchCase *c = &r->bench_case;
+
+        if (csv != NULL) {
+            fprintf(csv, "%s,%s,%d,%d,%d,%d,%lld,%.1f,%.1f,%.1f,%lld,%lld,%lld,%zu,%s\n",
+                    report->suite, c->scenario, c->threads, c->capacity, c->payload,
+                    r->reps, r->ops, r->ops_per_sec, r->ops_per_sec_min, r->ops_per_sec_max,
+                    r->p50_ns, r->p99_ns, r->p999_ns, r->samples, commit);
+        }
+        if (json != NULL) {
+            fprintf(json,
+                    "  {\"suite\": \"%s\", \"scenario\": \"%s\", \"threads\": %d, "
+                    "\"capacity\": %d, \"payload\": %d, \"reps\": %d, \"ops\": %lld, "
+                    "\"ops_per_sec\": %.1f, \"ops_per_sec_min\": %.1f, \"ops_per_sec_max\": %.1f, "
+                    "\"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld, "
+                    "\"samples\": %zu, \"commit\": \"%s\"}%s\n",
+                    report->suite, c->scenario, c->threads, c->capacity, c->payload,
+                    r->reps, r->ops, r->ops_per_sec, r->ops_per_sec_min, r->ops_per_sec_max,
+                    r->p50_ns, r->p99_ns, r->p999_ns, r->samples, commit,
+                    i + 1 < report->count ? "," : "");
+        }
+    }
+
+    if (json != NULL) {
+        fprintf(json, "]\n");
+        fclose(json);
+    } else {
+        status = -1;
+    }
+    if (csv != NULL) {
+        fclose(csv);
+    } else {
+        status = -1;
+    }
+
+    if (status == 0) {
+        printf("Results written to %s/%s_bench.{csv,json}\n",
+               report->config.output_dir, report->suite);
+    }
+
+    free(report->results);
+    report->results = NULL;
+    report->count = 0;
+    report->capacity = 0;
+    return status;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file bench_harness.h
+ * @brief Shared microbenchmark harness for the three lab tasks
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Runs a scenario a few times for warmup and then for the measured
+ * repetitions, collects per-operation latency samples, and reports ops/sec
+ * plus p50/p99/p999 latency. Every result is printed as a table row and
+ * written to <output>/<suite>_bench.csv and .json so runs can be compared
+ * across commits.
+ */
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BENCH_DEFAULT_WARMUP 1
+#define BENCH_DEFAULT_REPS 5
+#define BENCH_DEFAULT_OUTPUT_DIR "output"
+
+/**
+ * @brief Growable array of latency samples in nanoseconds
+ *
+ * Not thread-safe: give each worker thread its own and merge them with
+ * bench_samples_append() after joining.
+ */
+typedef struct {
+    long long *values;
+    size_t count;
+    size_t capacity;
+} BenchSamples;
+
+/**
+ * @brief Outcome of a single repetition, filled in by the scenario
+ */
+typedef struct {
+    long long ops;         // Operations completed in the measured window
+    double seconds;        // Length of the measured window
+    BenchSamples *samples; // Latency samples; scenarios append to it
+} BenchRun;
+
+/**
+ * @brief Scenario body: run once, fill run->ops and run->seconds
+ * @return 0 on success, -1 on failure
+ */
+typedef int (*BenchFn)(void *ctx, BenchRun *run);
+
+/**
+ * @brief Sweep dimensions identifying one benchmark case
+ *
+ * Dimensions that do not apply to a suite are left at 0.
+ */
+typedef struct {
+    const char *scenario; // Short scenario name, e.g. "tsq-records"
+    int threads;          // Worker threads (or active philosophers)
+    int capacity;         // Queue/buffer capacity
+    int payload;          // Element size in bytes
+} BenchCase;
+
+/**
+ * @brief Aggregated result of one case
+ */
+typedef struct {
+    BenchCase bench_case;
+    int reps;
+    long long ops;          // Operations per repetition (last repetition)
+    double ops_per_sec;     // Median over the repetitions
+    double ops_per_sec_min;
+    double ops_per_sec_max;
+    long long p50_ns;       // Latency percentiles over all measured samples
+    long long p99_ns;
+    long long p999_ns;
+    size_t samples;         // Number of latency samples behind the percentiles
+} BenchResult;
+
+/**
+ * @brief Run settings, usually parsed from the command line
+ */
+typedef struct {
+    int warmup;             // Discarded repetitions
+    int reps;               // Measured repetitions
+    bool quick;             // Scenarios should shrink their sweeps and sizes
+    const char *output_dir; // Where CSV/JSON files are written
+} BenchConfig;
+
+/**
+ * @brief Collected results of one benchmark program
+ */
+typedef struct {
+    const char *suite;
+    BenchConfig config;
+    BenchResult *results;
+    size_t count;
+    size_t capacity;
+} BenchReport;
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+long long bench_now_ns(void);
+
+void bench_samples_init(BenchSamples *samples);
+void bench_samples_free(BenchSamples *samples);
+
+/**
+ * @brief Record one latency sample (silently dropped if memory runs out)
+ */
+void bench_samples_add(BenchSamples *samples, long long ns);
+
+/**
+ * @brief Move every sample of src to the end of dst and empty src
+ */
+void bench_samples_append(BenchSamples *dst, BenchSamples *src);
+
+/**
+ * @brief Parse --warmup N, --reps N, --quick and --output DIR
+ *
+ * Unknown arguments are left alone so programs can add their own.
+ *
+ * @return 0 on success, -1 on a malformed option (usage already printed)
+ */
+int bench_parse_args(BenchConfig *config, int argc, char *argv[]);
+
+/**
+ * @brief Start a report and print the table header
+ * @param report Report to initialize
+ * @param suite Suite name, used for the output file names
+ * @param config Run settings (copied)
+ */
+void bench_report_init(BenchReport *report, const char *suite, const BenchConfig *config);
+
+/**
+ * @brief Run warmup and measured repetitions of one case and record the result
+ * @return 0 on success, -1 if the scenario failed
+ */
+int bench_run(BenchReport *report, const BenchCase *bench_case, BenchFn fn, void *ctx);
+
+/**
+ * @brief Write the CSV and JSON files and release the report
+ * @return 0 on success, -1 if the files could not be written
+ */
+int bench_report_finish(BenchReport *report);
+
+#endif // BENCH_HARNESS_H
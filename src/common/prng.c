@@ -0,0 +1,116 @@
+/**
+ * @file prng.c
+ * @brief Implementation of the per-thread PRNG
+ */
+
+#define _DEFAULT_SOURCE
+#include "prng.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PRNG_DEFAULT_SEED 0x5eed5eed5eed5eedULL
+
+// Streams for threads that never called prng_thread_seed(); the top bit
+// keeps them clear of PRNG_STREAM() ids with small domains
+#define PRNG_ANONYMOUS_STREAM (1ULL << 63)
+
+static _Atomic uint64_t master_seed = PRNG_DEFAULT_SEED;
+static atomic_uint_fast64_t anonymous_streams;
+
+static _Thread_local Prng thread_rng;
+static _Thread_local bool thread_seeded = false;
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t prng_splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void prng_seed(Prng *rng, uint64_t seed) {
+    // splitmix64 never yields four zero words in a row, so the state is valid
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = prng_splitmix64(&seed);
+    }
+}
+
+uint64_t prng_next(Prng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+uint32_t prng_below(Prng *rng, uint32_t bound) {
+    // Lemire's multiply-shift with rejection: unbiased, no division on the
+    // common path
+    uint64_t m = (prng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (prng_next(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+void prng_set_master_seed(uint64_t seed) {
+    atomic_store_explicit(&master_seed, seed, memory_order_relaxed);
+}
+
+uint64_t prng_master_seed(void) {
+    return atomic_load_explicit(&master_seed, memory_order_relaxed);
+}
+
+uint64_t prng_init_from_env(void) {
+    const char *value = getenv(PRNG_SEED_ENV);
+    uint64_t seed;
+
+    if (value && *value) {
+        seed = strtoull(value, NULL, 0);
+    } else {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t state = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+        seed = prng_splitmix64(&state);
+    }
+
+    prng_set_master_seed(seed);
+    return seed;
+}
+
+uint64_t prng_stream_seed(uint64_t stream) {
+    // Mix the stream first so neighbouring ids start far apart
+    uint64_t mixed = stream;
+    uint64_t state = prng_master_seed() ^ prng_splitmix64(&mixed);
+    return prng_splitmix64(&state);
+}
+
+void prng_thread_seed(uint64_t stream) {
+    prng_seed(&thread_rng, prng_stream_seed(stream));
+    thread_seeded = true;
+}
+
+Prng *prng_thread(void) {
+    if (!thread_seeded) {
+        uint64_t n = atomic_fetch_add_explicit(&anonymous_streams, 1, memory_order_relaxed);
+        prng_thread_seed(PRNG_ANONYMOUS_STREAM | n);
+    }
+    return &thread_rng;
+}
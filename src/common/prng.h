@@ -0,0 +1,103 @@
+/**
+ * @file prng.h
+ * @brief Per-thread pseudo-random numbers shared by the three lab tasks
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * xoshiro256** generators seeded through splitmix64. Every thread draws
+ * from its own generator, so there is no shared state or lock on the hot
+ * path (unlike rand(), which serializes all callers on glibc's internal
+ * lock). Each generator is derived from a process-wide master seed and a
+ * stream id chosen by the caller, e.g. "producer 2" or "philosopher 4":
+ * the same master seed and stream always replay the same sequence,
+ * regardless of which OS thread runs it or in what order threads start.
+ */
+
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdint.h>
+
+/** Environment variable read by prng_init_from_env() */
+#define PRNG_SEED_ENV "LAB_SEED"
+
+/**
+ * @brief Build a stream id from a caller-defined domain and a logical id
+ *
+ * Domains keep, say, producer 0 and consumer 0 on different streams.
+ */
+#define PRNG_STREAM(domain, id) (((uint64_t)(domain) << 32) | (uint32_t)(id))
+
+/**
+ * @brief xoshiro256** state; never all zero once seeded
+ */
+typedef struct {
+    uint64_t s[4];
+} Prng;
+
+/**
+ * @brief One splitmix64 step: advance *state and return the mixed value
+ */
+uint64_t prng_splitmix64(uint64_t *state);
+
+/**
+ * @brief Seed a generator by expanding seed with splitmix64
+ */
+void prng_seed(Prng *rng, uint64_t seed);
+
+/**
+ * @brief Next 64 random bits
+ */
+uint64_t prng_next(Prng *rng);
+
+/**
+ * @brief Uniform integer in [0, bound); returns 0 when bound is 0
+ */
+uint32_t prng_below(Prng *rng, uint32_t bound);
+
+/**
+ * @brief Set the master seed that stream generators are derived from
+ *
+ * Threads that already seeded their generator keep it; call this before
+ * starting workers.
+ */
+void prng_set_master_seed(uint64_t seed);
+
+/**
+ * @brief Current master seed (a fixed default until one is set)
+ */
+uint64_t prng_master_seed(void);
+
+/**
+ * @brief Take the master seed from LAB_SEED, or from the clock if unset
+ * @return The seed in use, so programs can print it for replay
+ */
+uint64_t prng_init_from_env(void);
+
+/**
+ * @brief Seed of stream `stream` under the current master seed
+ */
+uint64_t prng_stream_seed(uint64_t stream);
+
+/**
+ * @brief (Re)seed the calling thread's generator for a logical stream
+ *
+ * Call at the top of a worker thread with a stable id to make its draws
+ * reproducible. Threads that never call it get a stream of their own on
+ * first use, which is independent but depends on thread start order.
+ */
+void prng_thread_seed(uint64_t stream);
+
+/**
+ * @brief The calling thread's generator
+ */
+Prng *prng_thread(void);
+
+/**
+ * @brief Uniform integer in [0, bound) from the calling thread's generator
+ */
+static inline uint32_t prng_thread_below(uint32_t bound) {
+    return prng_below(prng_thread(), bound);
+}
+
+#endif // PRNG_H
@@ -0,0 +1,275 @@
+/**
+ * @file mpmc_queue.c
+ * @brief Implementation of the bounded lock-free MPMC queue
+ */
+
+#include "mpmc_queue.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static size_t round_up_pow2(size_t v) {
+    size_t p = 2;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static bool try_enqueue(MpmcQueue *q, int item) {
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for (;;) {
+        slot = &q->slots[pos & q->mask];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // Slot is free for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Slot still holds an item from the previous lap: queue is full
+            return false;
+        } else {
+            // Another producer claimed this position, reload
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->item = item;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool try_dequeue(MpmcQueue *q, int *item) {
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for (;;) {
+        slot = &q->slots[pos & q->mask];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            // Slot has been published for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Producer has not published this position yet: queue is empty
+            return false;
+        } else {
+            // Another consumer claimed this position, reload
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    *item = slot->item;
+    // Make the slot available to the producer one lap ahead
+    atomic_store_explicit(&slot->sequence, pos + q->mask + 1, memory_order_release);
+    return true;
+}
+
+/*
+ * Sleepers bump their *_waiting counter and retry while holding wait_lock;
+ * wakers finish their operation and then read the counter. The seq_cst fences
+ * guarantee that either the waker sees the sleeper or the sleeper's retry sees
+ * the waker's operation.
+ */
+static void wake_one(MpmcQueue *q, atomic_int *waiting, pthread_cond_t *cond) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiting, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&q->wait_lock);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&q->wait_lock);
+    }
+}
+
+int mpmc_queue_init(MpmcQueue *q, int capacity) {
+    if (q == NULL || capacity <= 0 || (unsigned)capacity > MPMC_MAX_CAPACITY) {
+        return -1;
+    }
+
+    q->capacity = round_up_pow2((size_t)capacity);
+    q->mask = q->capacity - 1;
+
+    // Allocate memory for slots
+    q->slots = malloc(q->capacity * sizeof(MpmcSlot));
+    if (q->slots == NULL) {
+        return -1;
+    }
+
+    // Slot i is initially ready for the producer at position i
+    for (size_t i = 0; i < q->capacity; i++) {
+        atomic_init(&q->slots[i].sequence, i);
+    }
+
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    atomic_init(&q->producers_waiting, 0);
+    atomic_init(&q->consumers_waiting, 0);
+
+    if (pthread_mutex_init(&q->wait_lock, NULL) != 0) {
+        free(q->slots);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&q->wait_lock);
+        free(q->slots);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_full, NULL) != 0) {
+        pthread_cond_destroy(&q->not_empty);
+        pthread_mutex_destroy(&q->wait_lock);
+        free(q->slots);
+        return -1;
+    }
+
+    return 0;
+}
+
+void mpmc_queue_destroy(MpmcQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    pthread_mutex_destroy(&q->wait_lock);
+
+    free(q->slots);
+    q->slots = NULL;
+}
+
+int mpmc_enqueue_nonblocking(MpmcQueue *q, int item) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    if (!try_enqueue(q, item)) {
+        return -1;
+    }
+
+    wake_one(q, &q->consumers_waiting, &q->not_empty);
+    return 0;
+}
+
+int mpmc_dequeue_nonblocking(MpmcQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return -1;
+    }
+
+    if (!try_dequeue(q, item)) {
+        return -1;
+    }
+
+    wake_one(q, &q->producers_waiting, &q->not_full);
+    return 0;
+}
+
+int mpmc_enqueue(MpmcQueue *q, int item) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    // Fast path plus a short spin before paying for a sleep
+    for (int spin = 0; spin < MPMC_SPIN_LIMIT; spin++) {
+        if (try_enqueue(q, item)) {
+            wake_one(q, &q->consumers_waiting, &q->not_empty);
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    pthread_mutex_lock(&q->wait_lock);
+    atomic_fetch_add_explicit(&q->producers_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    while (!try_enqueue(q, item)) {
+        pthread_cond_wait(&q->not_full, &q->wait_lock);
+    }
+
+    atomic_fetch_sub_explicit(&q->producers_waiting, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&q->wait_lock);
+
+    wake_one(q, &q->consumers_waiting, &q->not_empty);
+    return 0;
+}
+
+int mpmc_dequeue(MpmcQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return -1;
+    }
+
+    // Fast path plus a short spin before paying for a sleep
+    for (int spin = 0; spin < MPMC_SPIN_LIMIT; spin++) {
+        if (try_dequeue(q, item)) {
+            wake_one(q, &q->producers_waiting, &q->not_full);
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    pthread_mutex_lock(&q->wait_lock);
+    atomic_fetch_add_explicit(&q->consumers_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    while (!try_dequeue(q, item)) {
+        pthread_cond_wait(&q->not_empty, &q->wait_lock);
+    }
+
+    atomic_fetch_sub_explicit(&q->consumers_waiting, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&q->wait_lock);
+
+    wake_one(q, &q->producers_waiting, &q->not_full);
+    return 0;
+}
+
+int mpmc_queue_size(MpmcQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    // Read dequeue_pos first so the difference can only over-estimate
+    size_t head = atomic_load_explicit(&q->dequeue_pos, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->enqueue_pos, memory_order_acquire);
+    size_t size = tail - head;
+
+    // Claimed-but-unfinished operations can briefly push the estimate out of range
+    if ((intptr_t)size < 0) {
+        return 0;
+    }
+    return size > q->capacity ? (int)q->capacity : (int)size;
+}
+
+bool mpmc_queue_is_empty(MpmcQueue *q) {
+    if (q == NULL) {
+        return true;
+    }
+
+    return mpmc_queue_size(q) == 0;
+}
+
+bool mpmc_queue_is_full(MpmcQueue *q) {
+    if (q == NULL) {
+        return false;
+    }
+
+    return mpmc_queue_size(q) == (int)q->capacity;
+}
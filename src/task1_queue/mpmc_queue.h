@@ -0,0 +1,127 @@
+/**
+ * @file mpmc_queue.h
+ * @brief Bounded lock-free multi-producer/multi-consumer queue
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Array-based queue in the style of Dmitry Vyukov's bounded MPMC queue: each
+ * slot carries a sequence number that tells producers and consumers whether
+ * the slot is ready for them, so the only shared writes on the hot path are
+ * one CAS on the enqueue or dequeue position. Exposes the same contract as
+ * thread_safe_queue.h so it can be swapped in for ThreadSafeQueue.
+ */
+
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MPMC_CACHE_LINE 64
+#define MPMC_MAX_CAPACITY (1u << 30)
+#define MPMC_SPIN_LIMIT 128
+
+/**
+ * @brief One slot of the ring: sequence stamp plus payload
+ */
+typedef struct {
+    atomic_size_t sequence; // Position this slot is ready for
+    int item;               // Stored item
+} MpmcSlot;
+
+/**
+ * @brief Multi-producer/multi-consumer queue structure
+ */
+typedef struct {
+    // Read-only after initialization
+    _Alignas(MPMC_CACHE_LINE) MpmcSlot *slots; // Ring of sequence-stamped slots
+    size_t mask;                               // capacity - 1
+    size_t capacity;                           // Maximum capacity (power of two)
+
+    // Claimed by producers
+    _Alignas(MPMC_CACHE_LINE) atomic_size_t enqueue_pos;
+
+    // Claimed by consumers
+    _Alignas(MPMC_CACHE_LINE) atomic_size_t dequeue_pos;
+
+    // Slow path, only used when a thread has to block
+    _Alignas(MPMC_CACHE_LINE) atomic_int producers_waiting;
+    atomic_int consumers_waiting;
+    pthread_mutex_t wait_lock; // Protects the sleep/wakeup handshake
+    pthread_cond_t not_empty;  // Consumers sleep here
+    pthread_cond_t not_full;   // Producers sleep here
+} MpmcQueue;
+
+/**
+ * @brief Initialize an MPMC queue
+ * @param q Pointer to the queue structure
+ * @param capacity Requested capacity, rounded up to the next power of two (minimum 2)
+ * @return 0 on success, -1 on failure
+ */
+int mpmc_queue_init(MpmcQueue *q, int capacity);
+
+/**
+ * @brief Destroy an MPMC queue and free resources
+ * @param q Pointer to the queue structure
+ */
+void mpmc_queue_destroy(MpmcQueue *q);
+
+/**
+ * @brief Add an item to the queue (blocking if full)
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @return 0 on success, -1 on failure
+ */
+int mpmc_enqueue(MpmcQueue *q, int item);
+
+/**
+ * @brief Remove an item from the queue (blocking if empty)
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 on failure
+ */
+int mpmc_dequeue(MpmcQueue *q, int *item);
+
+/**
+ * @brief Try to add an item without blocking
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @return 0 on success, -1 if queue is full or error
+ */
+int mpmc_enqueue_nonblocking(MpmcQueue *q, int item);
+
+/**
+ * @brief Try to remove an item without blocking
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 if queue is empty or error
+ */
+int mpmc_dequeue_nonblocking(MpmcQueue *q, int *item);
+
+/**
+ * @brief Get the approximate number of queued items
+ *
+ * Lock-free; concurrent operations may make the value stale immediately.
+ *
+ * @param q Pointer to the queue structure
+ * @return Current size, -1 on error
+ */
+int mpmc_queue_size(MpmcQueue *q);
+
+/**
+ * @brief Check if queue is empty (approximate, see mpmc_queue_size)
+ * @param q Pointer to the queue structure
+ * @return true if empty, false otherwise
+ */
+bool mpmc_queue_is_empty(MpmcQueue *q);
+
+/**
+ * @brief Check if queue is full (approximate, see mpmc_queue_size)
+ * @param q Pointer to the queue structure
+ * @return true if full, false otherwise
+ */
+bool mpmc_queue_is_full(MpmcQueue *q);
+
+#endif // MPMC_QUEUE_H
@@ -0,0 +1,261 @@
+/**
+ * @file priority_queue.c
+ * @brief Implementation of the banded priority queue
+ */
+
+#define _DEFAULT_SOURCE
+#include "priority_queue.h"
+#include <errno.h>
+#include <stdlib.h>
+
+static inline bool valid_priority(int priority) {
+    return priority >= 0 && priority < PRIORITY_BANDS;
+}
+
+// Wait on cond until woken or deadline (NULL = forever); false once the deadline passed
+static bool wait_on(PriorityQueue *q, pthread_cond_t *cond, const struct timespec *deadline) {
+    if (deadline == NULL) {
+        pthread_cond_wait(cond, &q->lock);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, &q->lock, deadline) != ETIMEDOUT;
+}
+
+static void push_band(PriorityQueue *q, int item, int priority) {
+    PriorityBand *band = &q->bands[priority];
+    int rear = band->front + band->count;
+    if (rear >= q->capacity) {
+        rear -= q->capacity;
+    }
+
+    band->items[rear] = item;
+    band->count++;
+    q->size++;
+    q->nonempty |= 1u << priority;
+}
+
+// Pop from the most urgent non-empty band; the queue must not be empty
+static void pop_band(PriorityQueue *q, int *item, int *priority) {
+    int b = __builtin_ctz(q->nonempty);
+    PriorityBand *band = &q->bands[b];
+
+    *item = band->items[band->front];
+    band->front = band->front + 1 == q->capacity ? 0 : band->front + 1;
+    band->count--;
+    q->size--;
+    if (band->count == 0) {
+        q->nonempty &= ~(1u << b);
+    }
+
+    if (priority != NULL) {
+        *priority = b;
+    }
+}
+
+int priority_queue_init(PriorityQueue *q, int capacity) {
+    if (q == NULL || capacity <= 0) {
+        return -1;
+    }
+
+    // Allocate memory for all bands at once
+    q->storage = malloc((size_t)PRIORITY_BANDS * capacity * sizeof(int));
+    if (q->storage == NULL) {
+        return -1;
+    }
+
+    for (int b = 0; b < PRIORITY_BANDS; b++) {
+        q->bands[b].items = q->storage + (size_t)b * capacity;
+        q->bands[b].front = 0;
+        q->bands[b].count = 0;
+    }
+
+    q->capacity = capacity;
+    q->size = 0;
+    q->nonempty = 0;
+    q->closed = false;
+
+    // Initialize mutex
+    if (pthread_mutex_init(&q->lock, NULL) != 0) {
+        free(q->storage);
+        return -1;
+    }
+
+    // Deadlines are CLOCK_MONOTONIC, as in ThreadSafeQueue
+    pthread_condattr_t attr;
+    if (pthread_condattr_init(&attr) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        free(q->storage);
+        return -1;
+    }
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    // Initialize condition variables
+    if (pthread_cond_init(&q->not_empty, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_destroy(&q->lock);
+        free(q->storage);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_full, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        pthread_cond_destroy(&q->not_empty);
+        pthread_mutex_destroy(&q->lock);
+        free(q->storage);
+        return -1;
+    }
+
+    pthread_condattr_destroy(&attr);
+    return 0;
+}
+
+void priority_queue_destroy(PriorityQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+
+    free(q->storage);
+    q->storage = NULL;
+}
+
+int priority_enqueue_timed(PriorityQueue *q, int item, int priority,
+                           const struct timespec *deadline) {
+    if (q == NULL || !valid_priority(priority)) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    // Wait while queue is full
+    while (q->size == q->capacity && !q->closed) {
+        if (!wait_on(q, &q->not_full, deadline) &&
+            q->size == q->capacity && !q->closed) {
+            pthread_mutex_unlock(&q->lock);
+            return QUEUE_TIMEOUT;
+        }
+    }
+
+    if (q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        return QUEUE_CLOSED;
+    }
+
+    push_band(q, item, priority);
+
+    // Signal that queue is not empty
+    pthread_cond_signal(&q->not_empty);
+
+    pthread_mutex_unlock(&q->lock);
+    return QUEUE_OK;
+}
+
+int priority_dequeue_timed(PriorityQueue *q, int *item, int *priority,
+                           const struct timespec *deadline) {
+    if (q == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    // Wait while queue is empty; a closed queue is still drained first
+    while (q->size == 0 && !q->closed) {
+        if (!wait_on(q, &q->not_empty, deadline) &&
+            q->size == 0 && !q->closed) {
+            pthread_mutex_unlock(&q->lock);
+            return QUEUE_TIMEOUT;
+        }
+    }
+
+    if (q->size == 0) {
+        pthread_mutex_unlock(&q->lock);
+        return QUEUE_CLOSED;
+    }
+
+    pop_band(q, item, priority);
+
+    // Signal that queue is not full
+    pthread_cond_signal(&q->not_full);
+
+    pthread_mutex_unlock(&q->lock);
+    return QUEUE_OK;
+}
+
+int priority_enqueue(PriorityQueue *q, int item, int priority) {
+    return priority_enqueue_timed(q, item, priority, NULL);
+}
+
+int priority_dequeue(PriorityQueue *q, int *item, int *priority) {
+    return priority_dequeue_timed(q, item, priority, NULL);
+}
+
+int priority_enqueue_nonblocking(PriorityQueue *q, int item, int priority) {
+    if (q == NULL || !valid_priority(priority)) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    int result = QUEUE_ERROR;
+    if (q->closed) {
+        result = QUEUE_CLOSED;
+    } else if (q->size < q->capacity) {
+        push_band(q, item, priority);
+        pthread_cond_signal(&q->not_empty);
+        result = QUEUE_OK;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int priority_dequeue_nonblocking(PriorityQueue *q, int *item, int *priority) {
+    if (q == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    int result = QUEUE_ERROR;
+    if (q->size > 0) {
+        pop_band(q, item, priority);
+        pthread_cond_signal(&q->not_full);
+        result = QUEUE_OK;
+    } else if (q->closed) {
+        result = QUEUE_CLOSED;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+void priority_queue_close(PriorityQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+
+    // Every waiter has to re-evaluate its condition
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+
+    pthread_mutex_unlock(&q->lock);
+}
+
+int priority_queue_size(PriorityQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    int size = q->size;
+    pthread_mutex_unlock(&q->lock);
+
+    return size;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file priority_queue.h
+ * @brief Bounded priority queue with a fixed number of FIFO bands
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Lets urgent control messages overtake bulk traffic through a single queue.
+ * Each priority band is its own ring; a bitmask of non-empty bands makes
+ * picking the highest one a single bit scan. Blocking, timeout and close
+ * semantics match ThreadSafeQueue, and so do the status codes.
+ */
+
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+#include "thread_safe_queue.h"
+#include <stdbool.h>
+#include <time.h>
+
+#define PRIORITY_BANDS 4 // Band 0 is the most urgent, PRIORITY_BANDS - 1 the least
+
+/**
+ * @brief One FIFO ring per priority level
+ */
+typedef struct {
+    int *items; // Slice of the shared storage, capacity slots
+    int front;  // Index of front element
+    int count;  // Elements currently in this band
+} PriorityBand;
+
+/**
+ * @brief Priority queue structure
+ *
+ * The capacity bounds the total across all bands, so any single band can
+ * hold the whole capacity.
+ */
+typedef struct {
+    PriorityBand bands[PRIORITY_BANDS];
+    int *storage;            // PRIORITY_BANDS * capacity ints backing the bands
+    int capacity;            // Maximum total number of elements
+    int size;                // Current total number of elements
+    unsigned nonempty;       // Bit b set while band b holds elements
+    bool closed;             // Set by priority_queue_close(), never cleared
+    pthread_mutex_t lock;    // Mutex for thread safety
+    pthread_cond_t not_empty; // Condition variable for non-empty queue
+    pthread_cond_t not_full;  // Condition variable for non-full queue
+} PriorityQueue;
+
+/**
+ * @brief Initialize a priority queue
+ * @param q Pointer to the queue structure
+ * @param capacity Maximum total capacity of the queue
+ * @return 0 on success, -1 on failure
+ */
+int priority_queue_init(PriorityQueue *q, int capacity);
+
+/**
+ * @brief Destroy a priority queue and free resources
+ * @param q Pointer to the queue structure
+ */
+void priority_queue_destroy(PriorityQueue *q);
+
+/**
+ * @brief Add an item with the given priority (blocks if full)
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @param priority Band in [0, PRIORITY_BANDS), 0 being the most urgent
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed
+ */
+int priority_enqueue(PriorityQueue *q, int item, int priority);
+
+/**
+ * @brief Remove the oldest item of the most urgent non-empty band (blocks if empty)
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @param priority Where to store the item's band (may be NULL)
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED once closed and drained
+ */
+int priority_dequeue(PriorityQueue *q, int *item, int *priority);
+
+/**
+ * @brief Add an item, giving up at an absolute CLOCK_MONOTONIC deadline
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT, QUEUE_CLOSED
+ */
+int priority_enqueue_timed(PriorityQueue *q, int item, int priority,
+                           const struct timespec *deadline);
+
+/**
+ * @brief Remove an item, giving up at an absolute CLOCK_MONOTONIC deadline
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT, QUEUE_CLOSED
+ */
+int priority_dequeue_timed(PriorityQueue *q, int *item, int *priority,
+                           const struct timespec *deadline);
+
+/**
+ * @brief Try to add an item without blocking
+ * @return 0 on success, -1 if full or on failure, QUEUE_CLOSED if closed
+ */
+int priority_enqueue_nonblocking(PriorityQueue *q, int item, int priority);
+
+/**
+ * @brief Try to remove an item without blocking
+ * @return 0 on success, -1 if empty or on failure, QUEUE_CLOSED once closed and drained
+ */
+int priority_dequeue_nonblocking(PriorityQueue *q, int *item, int *priority);
+
+/**
+ * @brief Close the queue and wake every waiter
+ * @param q Pointer to the queue structure
+ */
+void priority_queue_close(PriorityQueue *q);
+
+/**
+ * @brief Get the current total size of the queue
+ * @param q Pointer to the queue structure
+ * @return Current size, -1 on error
+ */
+int priority_queue_size(PriorityQueue *q);
+
+#endif // PRIORITY_QUEUE_H
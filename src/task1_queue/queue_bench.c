@@ -0,0 +1,879 @@
+/**
+ * @file queue_bench.c
+ * @brief Microbenchmarks for the thread-safe queue wait policies and layout
+ *
+ * The harness-driven part (handoff and stream per wait policy, the
+ * threads x capacity x payload sweep, and the lock-free and sharded queues
+ * against ThreadSafeQueue) is written to
+ * output/queue_bench.{csv,json}; the sections after it are one-off A/B
+ * comparisons printed to stdout.
+ */
+
+#define _GNU_SOURCE
+#include "thread_safe_queue.h"
+#include "sharded_queue.h"
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
+#include "priority_queue.h"
+#include "../bench/bench_harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define DEFAULT_ROUND_TRIPS 20000
+#define QUICK_ROUND_TRIPS 2000
+#define SWEEP_ITEMS 40000       // Items per sweep repetition, split over the producers
+#define SWEEP_MAX_PAYLOAD 256
+#define STREAM_ITEMS_FACTOR 10
+#define STREAM_CAPACITY 64
+#define SCALE_CAPACITY 1024    // Total capacity in the tsq vs sharded scaling sweep
+#define POLL_INTERVAL_NS 10000 // 100k polls/s at most, when the poller shares a core
+#define POLL_BUSY_MIN_CPUS 3   // Producer, consumer and poller each on a core of their own
+#define POLL_REPS 5            // Interleaved repetitions per mode; the median is reported
+
+#ifdef QUEUE_PACKED_LAYOUT
+#define LAYOUT_NAME "packed"
+#else
+#define LAYOUT_NAME "cache-line padded"
+#endif
+
+static const QueueWaitPolicy policies[] = {
+    QUEUE_WAIT_BLOCK,
+    QUEUE_WAIT_SPIN,
+    QUEUE_WAIT_SPIN_YIELD,
+    QUEUE_WAIT_ADAPTIVE
+};
+#define NUM_POLICIES (int)(sizeof(policies) / sizeof(policies[0]))
+
+typedef struct {
+    ThreadSafeQueue *in;
+    ThreadSafeQueue *out;
+    int count;
+} BenchArgs;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Hardware counter covering this thread and the threads it creates
+ * @return File descriptor, -1 when perf events are unavailable
+ */
+static int perf_counter_open(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void perf_counter_start(int fd) {
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+// Counts of threads that already exited are folded into the parent's counter
+static long long perf_counter_stop(int fd) {
+    long long value = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != sizeof(value)) {
+            value = -1;
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Echo every item from in back to out (the "pong" side of a handoff)
+ */
+static void *echo_thread(void *arg) {
+    BenchArgs *args = (BenchArgs *)arg;
+    int item;
+
+    for (int i = 0; i < args->count; i++) {
+        dequeue(args->in, &item);
+        enqueue(args->out, item);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Drain count items from in (the consumer side of a stream)
+ */
+static void *drain_thread(void *arg) {
+    BenchArgs *args = (BenchArgs *)arg;
+    int item;
+
+    for (int i = 0; i < args->count; i++) {
+        dequeue(args->in, &item);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Stream items from one producer to one consumer
+ * @return Throughput in millions of items per second, -1 on failure
+ */
+static double bench_stream(QueueWaitPolicy policy, int items) {
+    ThreadSafeQueue q;
+    if (queue_init(&q, STREAM_CAPACITY) != 0) {
+        return -1;
+    }
+    queue_set_wait_policy(&q, policy);
+
+    BenchArgs args = {&q, NULL, items};
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, drain_thread, &args);
+
+    double start = now_sec();
+    for (int i = 0; i < items; i++) {
+        enqueue(&q, i);
+    }
+    pthread_join(consumer, NULL);
+    double elapsed = now_sec() - start;
+
+    queue_destroy(&q);
+    return items / elapsed / 1e6;
+}
+
+static void *priority_drain_thread(void *arg) {
+    PriorityQueue *q = (PriorityQueue *)arg;
+    int item;
+
+    while (priority_dequeue(q, &item, NULL) == QUEUE_OK) {
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Same stream as bench_stream through the banded priority queue
+ * @param bands Number of bands the items are spread over (1 = FIFO-like)
+ * @return Throughput in millions of items per second, -1 on failure
+ */
+static double bench_priority_stream(int items, int bands) {
+    PriorityQueue q;
+    if (priority_queue_init(&q, STREAM_CAPACITY) != 0) {
+        return -1;
+    }
+
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, priority_drain_thread, &q);
+
+    double start = now_sec();
+    for (int i = 0; i < items; i++) {
+        priority_enqueue(&q, i, i % bands);
+    }
+    priority_queue_close(&q);
+    pthread_join(consumer, NULL);
+    double elapsed = now_sec() - start;
+
+    priority_queue_destroy(&q);
+    return items / elapsed / 1e6;
+}
+
+/**
+ * @brief Compare the priority queue against the plain FIFO
+ */
+static void bench_priority(int items) {
+    double fifo = bench_stream(QUEUE_WAIT_BLOCK, items);
+    double one_band = bench_priority_stream(items, 1);
+    double all_bands = bench_priority_stream(items, PRIORITY_BANDS);
+
+    printf("\nPriority queue vs FIFO (block policy, %d items)\n", items);
+    printf("  %-22s %8.2f Mops/s\n", "fifo", fifo);
+    printf("  %-22s %8.2f Mops/s (%+.1f%%)\n", "priority, 1 band",
+           one_band, (one_band / fifo - 1) * 100);
+    printf("  %-22s %8.2f Mops/s (%+.1f%%)\n", "priority, mixed bands",
+           all_bands, (all_bands / fifo - 1) * 100);
+}
+
+typedef struct {
+    ThreadSafeQueue *q;
+    bool locked;        // Read size under q->lock, as the observers used to
+    bool busy;          // Poll back to back instead of sleeping between polls
+    atomic_bool stop;
+    long long polls;
+} PollArgs;
+
+/**
+ * @brief Monitoring thread that polls the observers until told to stop
+ *
+ * With a core to itself it polls back to back, so a locking observer
+ * actually competes with the stream for the mutex and its cache line.
+ * Otherwise it sleeps POLL_INTERVAL_NS between polls, like a monitor
+ * sampling at a fixed rate, so it does not just steal CPU time from the
+ * stream.
+ */
+static void *poll_thread(void *arg) {
+    PollArgs *args = (PollArgs *)arg;
+    long long polls = 0;
+    long long seen = 0;
+    struct timespec interval = {0, POLL_INTERVAL_NS};
+
+    while (!atomic_load_explicit(&args->stop, memory_order_relaxed)) {
+        if (args->locked) {
+            pthread_mutex_lock(&args->q->lock);
+            seen += atomic_load_explicit(&args->q->size, memory_order_relaxed);
+            pthread_mutex_unlock(&args->q->lock);
+        } else {
+            seen += queue_size(args->q) + queue_is_empty(args->q) + queue_is_full(args->q);
+        }
+        polls++;
+        if (!args->busy) {
+            nanosleep(&interval, NULL);
+        }
+    }
+
+    args->polls = polls + (seen < 0); // Keep the reads from being optimized away
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief One stream run with the given poller mode; returns Mops/s
+ */
+static double polling_run(int mode, bool busy, int items, long long *polls) {
+    ThreadSafeQueue q;
+    if (queue_init(&q, STREAM_CAPACITY) != 0) {
+        fprintf(stderr, "Failed to initialize queue\n");
+        return -1;
+    }
+
+    PollArgs poll_args = {&q, mode == 2, busy, false, 0};
+    pthread_t poller;
+    if (mode > 0) {
+        pthread_create(&poller, NULL, poll_thread, &poll_args);
+    }
+
+    BenchArgs args = {&q, NULL, items};
+    pthread_t consumer;
+    double start = now_sec();
+    pthread_create(&consumer, NULL, drain_thread, &args);
+    for (int i = 0; i < items; i++) {
+        enqueue(&q, i);
+    }
+    pthread_join(consumer, NULL);
+    double mops = items / (now_sec() - start) / 1e6;
+
+    if (mode > 0) {
+        atomic_store(&poll_args.stop, true);
+        pthread_join(poller, NULL);
+        *polls += poll_args.polls;
+    }
+    queue_destroy(&q);
+    return mops;
+}
+
+/**
+ * @brief Stream throughput with no poller, a lock-free poller and a locking poller
+ *
+ * Modes are interleaved over POLL_REPS repetitions so slow drift hits all
+ * three alike; the spread is printed next to the median so a difference
+ * can be told apart from run-to-run noise.
+ */
+static void bench_polling(int items) {
+    static const char *names[] = {"no poller", "lock-free observers", "locked observers"};
+    double results[3][POLL_REPS];
+    long long polls[3] = {0, 0, 0};
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    bool busy = cpus >= POLL_BUSY_MIN_CPUS;
+
+    for (int rep = 0; rep < POLL_REPS; rep++) {
+        for (int mode = 0; mode < 3; mode++) {
+            results[mode][rep] = polling_run(mode, busy, items, &polls[mode]);
+            if (results[mode][rep] < 0) {
+                return;
+            }
+        }
+    }
+
+    printf("\nObserver polling (block policy, %d items, %s poller, median of %d)\n", items,
+           busy ? "busy" : "sleeping", POLL_REPS);
+    double base = 0;
+    for (int mode = 0; mode < 3; mode++) {
+        qsort(results[mode], POLL_REPS, sizeof(double), compare_doubles);
+        double median = results[mode][POLL_REPS / 2];
+        printf("  %-22s %8.2f Mops/s (%.2f-%.2f", names[mode], median,
+               results[mode][0], results[mode][POLL_REPS - 1]);
+        if (mode == 0) {
+            base = median;
+            printf(")\n");
+        } else {
+            printf(", %+.1f%%, %lld polls)\n", (median / base - 1) * 100, polls[mode] / POLL_REPS);
+        }
+    }
+
+    if (!busy) {
+        printf("  note: %ld CPU(s) online; the poller has to share a core with the stream,\n"
+               "        so it mostly costs CPU time and wakeups in both modes. The lock\n"
+               "        contention a locked observer adds needs >= %d cores to show.\n",
+               cpus, POLL_BUSY_MIN_CPUS);
+    }
+}
+
+/**
+ * @brief Stream through a heap queue and count coherence-related cache misses
+ */
+static void bench_layout(int items) {
+    ThreadSafeQueue *q = queue_create(STREAM_CAPACITY);
+    if (q == NULL) {
+        fprintf(stderr, "Failed to create queue\n");
+        return;
+    }
+
+    printf("\nLayout: %s (sizeof = %zu bytes)\n", LAYOUT_NAME, sizeof(ThreadSafeQueue));
+    printf("  lock/size line:  %zu\n", offsetof(ThreadSafeQueue, lock) / QUEUE_CACHE_LINE);
+    printf("  producer line:   %zu (rear, not_empty at %zu)\n",
+           offsetof(ThreadSafeQueue, rear) / QUEUE_CACHE_LINE,
+           offsetof(ThreadSafeQueue, not_empty) / QUEUE_CACHE_LINE);
+    printf("  consumer line:   %zu (front, not_full at %zu)\n",
+           offsetof(ThreadSafeQueue, front) / QUEUE_CACHE_LINE,
+           offsetof(ThreadSafeQueue, not_full) / QUEUE_CACHE_LINE);
+
+    int misses_fd = perf_counter_open(PERF_COUNT_HW_CACHE_MISSES);
+    int refs_fd = perf_counter_open(PERF_COUNT_HW_CACHE_REFERENCES);
+
+    BenchArgs args = {q, NULL, items};
+    pthread_t consumer;
+
+    perf_counter_start(misses_fd);
+    perf_counter_start(refs_fd);
+    double start = now_sec();
+
+    pthread_create(&consumer, NULL, drain_thread, &args);
+    for (int i = 0; i < items; i++) {
+        enqueue(q, i);
+    }
+    pthread_join(consumer, NULL);
+
+    double elapsed = now_sec() - start;
+    long long misses = perf_counter_stop(misses_fd);
+    long long refs = perf_counter_stop(refs_fd);
+
+    printf("  stream:          %.2f Mops/s\n", items / elapsed / 1e6);
+    if (misses >= 0 && refs >= 0) {
+        printf("  cache misses:    %.3f per item (%lld total)\n", (double)misses / items, misses);
+        printf("  cache refs:      %.3f per item (%lld total)\n", (double)refs / items, refs);
+    } else {
+        printf("  cache counters:  n/a (perf events unavailable)\n");
+    }
+
+    if (misses_fd >= 0) {
+        close(misses_fd);
+    }
+    if (refs_fd >= 0) {
+        close(refs_fd);
+    }
+    queue_free(q);
+}
+
+typedef struct {
+    QueueWaitPolicy policy;
+    int rounds;
+} HandoffCase;
+
+/**
+ * @brief Harness scenario: ping-pong handoff, one latency sample per round trip
+ */
+static int handoff_run(void *ctx, BenchRun *run) {
+    HandoffCase *hc = (HandoffCase *)ctx;
+    ThreadSafeQueue ping, pong;
+    if (queue_init(&ping, 1) != 0 || queue_init(&pong, 1) != 0) {
+        return -1;
+    }
+    queue_set_wait_policy(&ping, hc->policy);
+    queue_set_wait_policy(&pong, hc->policy);
+
+    BenchArgs args = {&ping, &pong, hc->rounds};
+    pthread_t echo;
+    pthread_create(&echo, NULL, echo_thread, &args);
+
+    long long start = bench_now_ns();
+    int item;
+    for (int i = 0; i < hc->rounds; i++) {
+        long long sent = bench_now_ns();
+        enqueue(&ping, i);
+        dequeue(&pong, &item);
+        bench_samples_add(run->samples, bench_now_ns() - sent);
+    }
+    run->seconds = (bench_now_ns() - start) / 1e9;
+    run->ops = hc->rounds;
+
+    pthread_join(echo, NULL);
+    queue_destroy(&ping);
+    queue_destroy(&pong);
+    return 0;
+}
+
+// Queue behind a stream scenario
+typedef enum {
+    STREAM_TSQ,     // ThreadSafeQueue: one lock for everybody
+    STREAM_SHARDED, // ShardedQueue with one lane per producer-consumer pair
+    STREAM_SPSC,    // Lock-free SpscQueue (one pair only)
+    STREAM_MPMC     // Lock-free MpmcQueue
+} StreamKind;
+
+typedef struct {
+    StreamKind kind;
+    QueueWaitPolicy policy; // STREAM_TSQ only
+    int pairs;    // Producers, and as many consumers
+    int capacity; // Total; split evenly over the lanes of a sharded queue
+    int items;
+    long long steals; // Summed over every repetition (STREAM_SHARDED)
+    long long spills;
+    long long moved;  // Items behind those sums
+} StreamCase;
+
+typedef struct {
+    const StreamCase *sc;
+    void *queue;
+    long long *stamps; // Enqueue time of each item, indexed by the item itself
+    int lane;          // Home lane (STREAM_SHARDED)
+    int first;         // First item of a producer
+    int count;
+    BenchSamples samples;
+} StreamWorker;
+
+static void stream_put(StreamWorker *w, int item) {
+    switch (w->sc->kind) {
+        case STREAM_SHARDED:
+            sharded_enqueue(w->queue, w->lane, item);
+            break;
+        case STREAM_SPSC:
+            spsc_enqueue(w->queue, item);
+            break;
+        case STREAM_MPMC:
+            mpmc_enqueue(w->queue, item);
+            break;
+        case STREAM_TSQ:
+        default:
+            enqueue(w->queue, item);
+            break;
+    }
+}
+
+static void stream_get(StreamWorker *w, int *item) {
+    switch (w->sc->kind) {
+        case STREAM_SHARDED:
+            sharded_dequeue(w->queue, w->lane, item);
+            break;
+        case STREAM_SPSC:
+            spsc_dequeue(w->queue, item);
+            break;
+        case STREAM_MPMC:
+            mpmc_dequeue(w->queue, item);
+            break;
+        case STREAM_TSQ:
+        default:
+            dequeue(w->queue, item);
+            break;
+    }
+}
+
+static void *stream_producer(void *arg) {
+    StreamWorker *w = (StreamWorker *)arg;
+
+    for (int i = w->first; i < w->first + w->count; i++) {
+        // Published to the consumer by the queue's own synchronization
+        w->stamps[i] = bench_now_ns();
+        stream_put(w, i);
+    }
+
+    return NULL;
+}
+
+static void *stream_consumer(void *arg) {
+    StreamWorker *w = (StreamWorker *)arg;
+    int item;
+
+    for (int i = 0; i < w->count; i++) {
+        stream_get(w, &item);
+        bench_samples_add(&w->samples, bench_now_ns() - w->stamps[item]);
+    }
+
+    return NULL;
+}
+
+// Storage for whichever queue a stream case uses
+typedef union {
+    ThreadSafeQueue tsq;
+    ShardedQueue sharded;
+    SpscQueue spsc;
+    MpmcQueue mpmc;
+} StreamQueue;
+
+// Create the queue of a stream case; 0 or -1
+static int stream_queue_init(StreamCase *sc, StreamQueue *storage, void **queue) {
+    *queue = storage;
+    switch (sc->kind) {
+        case STREAM_SPSC:
+            return sc->pairs == 1 ? spsc_queue_init(&storage->spsc, sc->capacity) : -1;
+        case STREAM_MPMC:
+            return mpmc_queue_init(&storage->mpmc, sc->capacity);
+        case STREAM_SHARDED: {
+            int lane_capacity = sc->capacity / sc->pairs;
+            return sharded_queue_init(&storage->sharded, sc->pairs,
+                                      lane_capacity > 0 ? lane_capacity : 1);
+        }
+        case STREAM_TSQ:
+        default:
+            if (queue_init(&storage->tsq, sc->capacity) != 0) {
+                return -1;
+            }
+            queue_set_wait_policy(&storage->tsq, sc->policy);
+            return 0;
+    }
+}
+
+static void stream_queue_destroy(StreamCase *sc, void *queue, int moved) {
+    switch (sc->kind) {
+        case STREAM_SHARDED: {
+            ShardedQueue *sharded = queue;
+            sc->steals += atomic_load(&sharded->steals);
+            sc->spills += atomic_load(&sharded->spills);
+            sc->moved += moved;
+            sharded_queue_destroy(sharded);
+            break;
+        }
+        case STREAM_SPSC:
+            spsc_queue_destroy(queue);
+            break;
+        case STREAM_MPMC:
+            mpmc_queue_destroy(queue);
+            break;
+        case STREAM_TSQ:
+        default:
+            queue_destroy(queue);
+            break;
+    }
+}
+
+/**
+ * @brief Harness scenario: int items from N producers to N consumers;
+ * latency is enqueue-to-dequeue time per item
+ */
+static int stream_run(void *ctx, BenchRun *run) {
+    StreamCase *sc = (StreamCase *)ctx;
+    int per_thread = sc->items / sc->pairs;
+    StreamQueue storage;
+    void *queue;
+    StreamWorker *workers = calloc(2 * sc->pairs, sizeof(StreamWorker));
+    pthread_t *tids = calloc(2 * sc->pairs, sizeof(pthread_t));
+    long long *stamps = calloc((size_t)per_thread * sc->pairs, sizeof(long long));
+    if (workers == NULL || tids == NULL || stamps == NULL ||
+        stream_queue_init(sc, &storage, &queue) != 0) {
+        free(workers);
+        free(tids);
+        free(stamps);
+        return -1;
+    }
+
+    long long start = bench_now_ns();
+    for (int i = 0; i < 2 * sc->pairs; i++) {
+        StreamWorker *w = &workers[i];
+        w->sc = sc;
+        w->queue = queue;
+        w->stamps = stamps;
+        w->lane = i % sc->pairs;
+        w->first = (i - sc->pairs) * per_thread;
+        w->count = per_thread;
+        bench_samples_init(&w->samples);
+        pthread_create(&tids[i], NULL, i < sc->pairs ? stream_consumer : stream_producer, w);
+    }
+    for (int i = 0; i < 2 * sc->pairs; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    run->seconds = (bench_now_ns() - start) / 1e9;
+    run->ops = (long long)per_thread * sc->pairs;
+
+    for (int i = 0; i < 2 * sc->pairs; i++) {
+        bench_samples_append(run->samples, &workers[i].samples);
+        bench_samples_free(&workers[i].samples);
+    }
+
+    stream_queue_destroy(sc, queue, per_thread * sc->pairs);
+    free(workers);
+    free(tids);
+    free(stamps);
+    return 0;
+}
+
+typedef struct {
+    int threads;  // Producers, and as many consumers
+    int capacity;
+    int payload;  // Element size; the first 8 bytes carry the enqueue timestamp
+    int items;
+} SweepCase;
+
+typedef struct {
+    ThreadSafeQueue *q;
+    int payload;
+    int count;
+    BenchSamples samples;
+} SweepWorker;
+
+static void *sweep_producer(void *arg) {
+    SweepWorker *w = (SweepWorker *)arg;
+    unsigned char elem[SWEEP_MAX_PAYLOAD];
+    memset(elem, 0xab, sizeof(elem));
+
+    for (int i = 0; i < w->count; i++) {
+        long long stamp = bench_now_ns();
+        memcpy(elem, &stamp, sizeof(stamp));
+        enqueue_elem(w->q, elem);
+    }
+
+    return NULL;
+}
+
+static void *sweep_consumer(void *arg) {
+    SweepWorker *w = (SweepWorker *)arg;
+    unsigned char elem[SWEEP_MAX_PAYLOAD];
+
+    for (int i = 0; i < w->count; i++) {
+        long long stamp;
+        dequeue_elem(w->q, elem);
+        memcpy(&stamp, elem, sizeof(stamp));
+        bench_samples_add(&w->samples, bench_now_ns() - stamp);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Harness scenario: N producers and N consumers streaming fixed-size
+ * records; latency is enqueue-to-dequeue time per item
+ */
+static int sweep_run(void *ctx, BenchRun *run) {
+    SweepCase *sc = (SweepCase *)ctx;
+    ThreadSafeQueue *q = queue_create_typed(sc->capacity, sc->payload, _Alignof(long long));
+    SweepWorker *workers = calloc(2 * sc->threads, sizeof(SweepWorker));
+    pthread_t *tids = calloc(2 * sc->threads, sizeof(pthread_t));
+    if (q == NULL || workers == NULL || tids == NULL) {
+        queue_free(q);
+        free(workers);
+        free(tids);
+        return -1;
+    }
+
+    int per_thread = sc->items / sc->threads;
+    long long start = bench_now_ns();
+
+    for (int i = 0; i < 2 * sc->threads; i++) {
+        workers[i].q = q;
+        workers[i].payload = sc->payload;
+        workers[i].count = per_thread;
+        bench_samples_init(&workers[i].samples);
+        pthread_create(&tids[i], NULL, i < sc->threads ? sweep_consumer : sweep_producer,
+                       &workers[i]);
+    }
+    for (int i = 0; i < 2 * sc->threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    run->seconds = (bench_now_ns() - start) / 1e9;
+    run->ops = (long long)per_thread * sc->threads;
+
+    for (int i = 0; i < 2 * sc->threads; i++) {
+        bench_samples_append(run->samples, &workers[i].samples);
+        bench_samples_free(&workers[i].samples);
+    }
+
+    queue_free(q);
+    free(workers);
+    free(tids);
+    return 0;
+}
+
+/**
+ * @brief Harness-driven cases: handoff per wait policy, then the sweep
+ */
+static int run_harness(const BenchConfig *config, int rounds) {
+    static const char *handoff_names[] = {
+        "handoff-block", "handoff-spin", "handoff-spinyield", "handoff-adaptive"
+    };
+    static const char *stream_names[] = {
+        "stream-block", "stream-spin", "stream-spinyield", "stream-adaptive"
+    };
+    static const int threads_full[] = {1, 2, 4};
+    static const int capacities_full[] = {16, 1024};
+    static const int payloads_full[] = {8, 64, 256};
+    static const int threads_quick[] = {1, 2};
+    static const int capacities_quick[] = {64};
+    static const int payloads_quick[] = {8, 64};
+
+    const int *threads = config->quick ? threads_quick : threads_full;
+    const int *capacities = config->quick ? capacities_quick : capacities_full;
+    const int *payloads = config->quick ? payloads_quick : payloads_full;
+    int num_threads = config->quick ? 2 : 3;
+    int num_capacities = config->quick ? 1 : 2;
+    int num_payloads = config->quick ? 2 : 3;
+
+    BenchReport report;
+    bench_report_init(&report, "queue", config);
+
+    // Per wait policy: ping-pong round trips, then a 1x1 stream
+    int best = 0;
+    double best_ops = 0;
+    for (int i = 0; i < NUM_POLICIES; i++) {
+        HandoffCase hc = {policies[i], rounds};
+        BenchCase bc = {handoff_names[i], 2, 1, (int)sizeof(int)};
+        if (bench_run(&report, &bc, handoff_run, &hc) != 0) {
+            bench_report_finish(&report);
+            return -1;
+        }
+        double ops = report.results[report.count - 1].ops_per_sec;
+        if (ops > best_ops) {
+            best = i;
+            best_ops = ops;
+        }
+    }
+
+    for (int i = 0; i < NUM_POLICIES; i++) {
+        StreamCase sc = {STREAM_TSQ, policies[i], 1, STREAM_CAPACITY, rounds * STREAM_ITEMS_FACTOR,
+                         0, 0, 0};
+        BenchCase bc = {stream_names[i], 2, STREAM_CAPACITY, (int)sizeof(int)};
+        if (bench_run(&report, &bc, stream_run, &sc) != 0) {
+            bench_report_finish(&report);
+            return -1;
+        }
+    }
+
+    int items = config->quick ? SWEEP_ITEMS / 10 : SWEEP_ITEMS;
+    double tsq_1x1[2] = {0, 0}; // Smallest records, one producer, per capacity
+    for (int t = 0; t < num_threads; t++) {
+        for (int c = 0; c < num_capacities; c++) {
+            for (int p = 0; p < num_payloads; p++) {
+                SweepCase sc = {threads[t], capacities[c], payloads[p], items};
+                BenchCase bc = {"tsq-records", 2 * threads[t], capacities[c], payloads[p]};
+                if (bench_run(&report, &bc, sweep_run, &sc) != 0) {
+                    bench_report_finish(&report);
+                    return -1;
+                }
+                if (threads[t] == 1 && p == 0) {
+                    tsq_1x1[c] = report.results[report.count - 1].ops_per_sec;
+                }
+            }
+
+            // The lock-free MPMC ring at the same threads, capacity and items
+            StreamCase mc = {STREAM_MPMC, QUEUE_WAIT_BLOCK, threads[t], capacities[c], items,
+                             0, 0, 0};
+            BenchCase mbc = {"mpmc", 2 * threads[t], capacities[c], (int)sizeof(int)};
+            if (bench_run(&report, &mbc, stream_run, &mc) != 0) {
+                bench_report_finish(&report);
+                return -1;
+            }
+        }
+    }
+
+    // The lock-free SPSC ring on the 1x1 case: same items and capacities
+    double spsc_1x1[2] = {0, 0};
+    for (int c = 0; c < num_capacities; c++) {
+        StreamCase sc = {STREAM_SPSC, QUEUE_WAIT_BLOCK, 1, capacities[c], items, 0, 0, 0};
+        BenchCase bc = {"spsc", 2, capacities[c], (int)sizeof(int)};
+        if (bench_run(&report, &bc, stream_run, &sc) != 0) {
+            bench_report_finish(&report);
+            return -1;
+        }
+        spsc_1x1[c] = report.results[report.count - 1].ops_per_sec;
+    }
+
+    // Scaling: one lock (tsq) against one lane per pair (sharded), with
+    // the same total capacity and items
+    static const int scale_pairs[] = {1, 2, 4, 8};
+    int num_scale = (int)(sizeof(scale_pairs) / sizeof(scale_pairs[0]));
+    StreamCase sharded_cases[sizeof(scale_pairs) / sizeof(scale_pairs[0])];
+    for (int t = 0; t < num_scale; t++) {
+        StreamCase tsq_case = {STREAM_TSQ, QUEUE_WAIT_BLOCK, scale_pairs[t], SCALE_CAPACITY,
+                               items, 0, 0, 0};
+        sharded_cases[t] = (StreamCase){STREAM_SHARDED, QUEUE_WAIT_BLOCK, scale_pairs[t],
+                                        SCALE_CAPACITY, items, 0, 0, 0};
+        BenchCase tsq_bc = {"tsq", 2 * scale_pairs[t], SCALE_CAPACITY, (int)sizeof(int)};
+        BenchCase sharded_bc = {"sharded", 2 * scale_pairs[t], SCALE_CAPACITY, (int)sizeof(int)};
+        if (bench_run(&report, &tsq_bc, stream_run, &tsq_case) != 0 ||
+            bench_run(&report, &sharded_bc, stream_run, &sharded_cases[t]) != 0) {
+            bench_report_finish(&report);
+            return -1;
+        }
+    }
+
+    int result = bench_report_finish(&report);
+
+    printf("\nOne producer, one consumer (%d items, median ops/s)\n", items);
+    printf("%-8s %14s %14s %8s\n", "capacity", "tsq-records", "spsc", "ratio");
+    for (int c = 0; c < num_capacities; c++) {
+        printf("%-8d %14.0f %14.0f %7.1fx\n", capacities[c], tsq_1x1[c], spsc_1x1[c],
+               tsq_1x1[c] > 0 ? spsc_1x1[c] / tsq_1x1[c] : 0);
+    }
+
+    printf("\nSharded lanes (all repetitions, per item moved)\n");
+    printf("%-8s %10s %10s\n", "pairs", "steals", "spills");
+    for (int t = 0; t < num_scale; t++) {
+        StreamCase *sc = &sharded_cases[t];
+        double moved = sc->moved > 0 ? (double)sc->moved : 1;
+        printf("%-8d %10.3f %10.3f\n", sc->pairs, sc->steals / moved, sc->spills / moved);
+    }
+    printf("\nLowest-latency handoff: %s (%.0f ns per round trip at the median rate)\n",
+           queue_wait_policy_name(policies[best]), best_ops > 0 ? 1e9 / best_ops : 0);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config;
+    if (bench_parse_args(&config, argc, argv) != 0) {
+        return 1;
+    }
+
+    // A leading number keeps the old "queue_bench [round_trips]" usage
+    int rounds = config.quick ? QUICK_ROUND_TRIPS : DEFAULT_ROUND_TRIPS;
+    if (argc > 1 && argv[1][0] != '-') {
+        rounds = atoi(argv[1]);
+        if (rounds <= 0) {
+            fprintf(stderr, "Usage: %s [round_trips] [--warmup N] [--reps N] [--quick] [--output DIR]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    printf("Thread-Safe Queue Benchmark\n");
+    printf("===========================\n");
+
+    if (run_harness(&config, rounds) != 0) {
+        return 1;
+    }
+
+    bench_priority(rounds * STREAM_ITEMS_FACTOR);
+    bench_polling(rounds * STREAM_ITEMS_FACTOR);
+
+    // Compare against build/queue_bench_packed for the false-sharing A/B
+    bench_layout(rounds * STREAM_ITEMS_FACTOR);
+    return 0;
+}
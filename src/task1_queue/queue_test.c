@@ -5,6 +5,12 @@
 
 #define _GNU_SOURCE
 #include "thread_safe_queue.h"
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
+#include "sharded_queue.h"
+#include "priority_queue.h"
+#include "segmented_queue.h"
+#include "../common/prng.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -13,11 +19,27 @@
 #include <assert.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/resource.h>
 
 #define NUM_PRODUCERS 3
 #define NUM_CONSUMERS 2
 #define ITEMS_PER_PRODUCER 10
 #define QUEUE_CAPACITY 5
+#define SPSC_TEST_ITEMS 200000
+#define BATCH_TEST_ITEMS 10000
+#define BATCH_CHUNK 64
+#define TYPED_TEST_ITEMS 5000
+#define POLICY_TEST_ITEMS 20000
+#define SHARDED_LANES 4
+#define SHARDED_ITEMS_PER_PRODUCER 2000
+#define SHARDED_IDLE_MS 50 // How long the idle-consumer check leaves every lane empty
+#define PRIORITY_TEST_ITEMS 20000
+#define SEGMENTED_BURST (SEGMENT_SIZE * 8 + 7)
+#define SEGMENTED_SOFT_LIMIT 64
+#define MPMC_THREADS 4
+#define MPMC_ITEMS_PER_PRODUCER 20000
 
 // Global queue for testing
 ThreadSafeQueue test_queue;
@@ -52,6 +74,7 @@ void safe_printf(const char *format, ...) {
  */
 void *producer_thread(void *arg) {
     int producer_id = *(int *)arg;
+    prng_thread_seed(PRNG_STREAM(1, producer_id));
     
     if (verbose_mode) safe_printf("Producer %d started\n", producer_id);
     
@@ -75,7 +98,7 @@ void *producer_thread(void *arg) {
         }
         
         // Small delay to simulate work
-        usleep(rand() % 1000); // 0-1ms
+        usleep(prng_thread_below(1000)); // 0-1ms
     }
     
     // Signal that this producer is finished
@@ -147,7 +170,7 @@ int test_basic_operations() {
     printf("\n=== Testing Basic Operations ===\n");
     
     ThreadSafeQueue queue;
-    if (init_queue(&queue) != 0) {
+    if (queue_init(&queue, MAX_QUEUE_SIZE) != 0) {
         printf("Failed to initialize queue\n");
         return -1;
     }
@@ -156,15 +179,15 @@ int test_basic_operations() {
     for (int i = 0; i < 5; i++) {
         if (enqueue(&queue, i * 10) != 0) {
             printf("Failed to enqueue item %d\n", i);
-            destroy_queue(&queue);
+            queue_destroy(&queue);
             return -1;
         }
     }
     
     // Test size
-    if (get_queue_size(&queue) != 5) {
-        printf("Expected size 5, got %d\n", get_queue_size(&queue));
-        destroy_queue(&queue);
+    if (queue_size(&queue) != 5) {
+        printf("Expected size 5, got %d\n", queue_size(&queue));
+        queue_destroy(&queue);
         return -1;
     }
     
@@ -173,34 +196,34 @@ int test_basic_operations() {
         int item;
         if (dequeue(&queue, &item) != 0) {
             printf("Failed to dequeue item %d\n", i);
-            destroy_queue(&queue);
+            queue_destroy(&queue);
             return -1;
         }
         
         int expected = i * 10;
         if (item != expected) {
             printf("Expected %d, got %d\n", expected, item);
-            destroy_queue(&queue);
+            queue_destroy(&queue);
             return -1;
         }
     }
     
     // Test empty queue
-    if (get_queue_size(&queue) != 0) {
-        printf("Expected empty queue, size is %d\n", get_queue_size(&queue));
-        destroy_queue(&queue);
+    if (queue_size(&queue) != 0) {
+        printf("Expected empty queue, size is %d\n", queue_size(&queue));
+        queue_destroy(&queue);
         return -1;
     }
     
-    // Test dequeue from empty queue
+    // Test dequeue from empty queue (blocking dequeue would wait forever)
     int item;
-    if (dequeue(&queue, &item) == 0) {
+    if (dequeue_nonblocking(&queue, &item) == 0) {
         printf("Dequeue from empty queue should fail\n");
-        destroy_queue(&queue);
+        queue_destroy(&queue);
         return -1;
     }
     
-    destroy_queue(&queue);
+    queue_destroy(&queue);
     printf("Basic operations test: PASSED\n");
     return 0;
 }
@@ -281,6 +304,1038 @@ void test_multithreaded() {
     queue_destroy(&test_queue);
 }
 
+/**
+ * @brief Batch producer: pushes a strictly increasing sequence in chunks
+ */
+void *batch_producer_thread(void *arg) {
+    ThreadSafeQueue *q = (ThreadSafeQueue *)arg;
+    int chunk[BATCH_CHUNK];
+
+    for (int base = 0; base < BATCH_TEST_ITEMS; base += BATCH_CHUNK) {
+        int n = BATCH_TEST_ITEMS - base < BATCH_CHUNK ? BATCH_TEST_ITEMS - base : BATCH_CHUNK;
+        for (int i = 0; i < n; i++) {
+            chunk[i] = base + i;
+        }
+        if (enqueue_batch(q, chunk, n) != n) {
+            safe_printf("Batch producer failed at item %d\n", base);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Test batch enqueue/dequeue, including ring wraparound
+ */
+int test_batch_operations() {
+    safe_printf("\n=== Testing Batch Operations ===\n");
+
+    ThreadSafeQueue queue;
+    if (queue_init(&queue, 8) != 0) {
+        safe_printf("Failed to initialize queue\n");
+        return -1;
+    }
+
+    // Move front/rear away from zero so the next batch wraps around
+    int first[5] = {0, 1, 2, 3, 4};
+    int out[16];
+    if (enqueue_batch(&queue, first, 5) != 5 || dequeue_batch(&queue, out, 3, 3) != 3) {
+        safe_printf("Failed to prime queue\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    int second[6] = {5, 6, 7, 8, 9, 10};
+    if (enqueue_batch(&queue, second, 6) != 6 || queue_size(&queue) != 8) {
+        safe_printf("Wrapping batch enqueue failed\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    int count = dequeue_batch(&queue, out, 16, 0);
+    bool ordered = (count == 8);
+    for (int i = 0; ordered && i < count; i++) {
+        ordered = (out[i] == i + 3);
+    }
+    if (!ordered) {
+        safe_printf("Wrapping batch dequeue returned %d items out of order\n", count);
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // min_wait of 0 must not block on an empty queue
+    if (dequeue_batch(&queue, out, 16, 0) != 0) {
+        safe_printf("Non-blocking batch dequeue on empty queue should return 0\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Concurrent batches larger than the ring force chunking on both sides
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, batch_producer_thread, &queue) != 0) {
+        safe_printf("Failed to create batch producer thread\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    int received = 0;
+    int errors = 0;
+    while (received < BATCH_TEST_ITEMS) {
+        int remaining = BATCH_TEST_ITEMS - received;
+        int got = dequeue_batch(&queue, out, 16, remaining < 4 ? remaining : 4);
+        for (int i = 0; i < got; i++) {
+            if (out[i] != received + i) {
+                errors++;
+            }
+        }
+        received += got;
+    }
+
+    pthread_join(producer, NULL);
+
+    bool success = errors == 0 && queue_size(&queue) == 0;
+    safe_printf("Transferred %d items in batches, %d out of order\n", received, errors);
+
+    // A closed queue hands out what is left, then reports the close on
+    // every path, including the non-blocking one
+    int tail[2] = {1, 2};
+    enqueue_batch(&queue, tail, 2);
+    queue_close(&queue);
+    bool drained = dequeue_batch(&queue, out, 16, 4) == 2 &&
+                   dequeue_batch(&queue, out, 16, 0) == QUEUE_CLOSED &&
+                   dequeue_batch(&queue, out, 16, 4) == QUEUE_CLOSED;
+    if (!drained) {
+        safe_printf("Batch dequeue on a closed, drained queue should return QUEUE_CLOSED\n");
+        success = false;
+    }
+    safe_printf("Batch operations test: %s\n", success ? "PASSED" : "FAILED");
+
+    queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Record used to exercise queues of non-int payloads
+ */
+typedef struct {
+    long id;
+    double value;
+    char tag[20];
+} TestMessage;
+
+/**
+ * @brief Typed producer: builds every message directly in queue memory
+ */
+void *typed_producer_thread(void *arg) {
+    ThreadSafeQueue *q = (ThreadSafeQueue *)arg;
+
+    for (int i = 0; i < TYPED_TEST_ITEMS; i++) {
+        TestMessage *msg = queue_reserve_slot(q);
+        if (msg == NULL) {
+            safe_printf("Typed producer failed to reserve slot %d\n", i);
+            break;
+        }
+        msg->id = i;
+        msg->value = i * 0.5;
+        snprintf(msg->tag, sizeof(msg->tag), "msg-%d", i);
+        queue_commit_slot(q);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Test queues of fixed-size records and zero-copy slot access
+ */
+int test_typed_queue() {
+    safe_printf("\n=== Testing Typed Queue ===\n");
+
+    ThreadSafeQueue queue;
+    if (queue_init_typed(&queue, 4, sizeof(TestMessage), _Alignof(TestMessage)) != 0) {
+        safe_printf("Failed to initialize typed queue\n");
+        return -1;
+    }
+
+    // The int API must refuse a queue of records
+    int dummy;
+    if (enqueue_nonblocking(&queue, 1) == 0 || dequeue_nonblocking(&queue, &dummy) == 0) {
+        safe_printf("Int API should reject a typed queue\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Even when the records are int-sized
+    ThreadSafeQueue floats;
+    if (queue_init_typed(&floats, 4, sizeof(float), _Alignof(float)) != 0) {
+        safe_printf("Failed to initialize float queue\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+    bool rejected = enqueue_nonblocking(&floats, 1) != 0 &&
+                    dequeue_nonblocking(&floats, &dummy) != 0 &&
+                    enqueue(&floats, 1) != 0 && dequeue(&floats, &dummy) != 0;
+    queue_destroy(&floats);
+    if (!rejected) {
+        safe_printf("Int API should reject a queue of int-sized records\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Copying API round trip
+    TestMessage in = {42, 3.25, "hello"};
+    TestMessage out;
+    if (enqueue_elem(&queue, &in) != 0 || dequeue_elem(&queue, &out) != 0 ||
+        out.id != 42 || out.value != 3.25 || strcmp(out.tag, "hello") != 0) {
+        safe_printf("Typed enqueue/dequeue round trip failed\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Zero-copy producer and consumer through a small ring
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, typed_producer_thread, &queue) != 0) {
+        safe_printf("Failed to create typed producer thread\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    int errors = 0;
+    for (int i = 0; i < TYPED_TEST_ITEMS; i++) {
+        const TestMessage *msg = queue_peek_slot(&queue);
+        char expected_tag[20];
+        snprintf(expected_tag, sizeof(expected_tag), "msg-%d", i);
+        if (msg == NULL || msg->id != i || msg->value != i * 0.5 ||
+            strcmp(msg->tag, expected_tag) != 0 ||
+            (uintptr_t)msg % _Alignof(TestMessage) != 0) {
+            errors++;
+        }
+        queue_release_slot(&queue);
+    }
+
+    pthread_join(producer, NULL);
+
+    bool success = errors == 0 && queue_size(&queue) == 0;
+    safe_printf("Transferred %d records in place, %d mismatches\n", TYPED_TEST_ITEMS, errors);
+    safe_printf("Typed queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Consumer that relies on queue_close() instead of polling counters
+ */
+void *closing_consumer_thread(void *arg) {
+    ThreadSafeQueue *q = (ThreadSafeQueue *)arg;
+    int item;
+    int status;
+
+    while ((status = dequeue(q, &item)) == QUEUE_OK) {
+        pthread_mutex_lock(&stats_lock);
+        total_consumed++;
+        pthread_mutex_unlock(&stats_lock);
+    }
+
+    if (status != QUEUE_CLOSED) {
+        safe_printf("Consumer exited with unexpected status %d\n", status);
+    }
+    return NULL;
+}
+
+static long elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * @brief Test deadline-based operations and queue_close() shutdown
+ */
+int test_timeouts_and_close() {
+    safe_printf("\n=== Testing Timeouts and Close ===\n");
+
+    ThreadSafeQueue queue;
+    if (queue_init(&queue, 2) != 0) {
+        safe_printf("Failed to initialize queue\n");
+        return -1;
+    }
+
+    struct timespec start, deadline;
+    int item;
+
+    // Timed dequeue on an empty queue gives up at the deadline
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    queue_deadline_in(&deadline, 50);
+    int status = dequeue_timed(&queue, &item, &deadline);
+    long waited = elapsed_ms(&start);
+    if (status != QUEUE_TIMEOUT || waited < 45) {
+        safe_printf("dequeue_timed returned %d after %ld ms\n", status, waited);
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Timed enqueue on a full queue gives up at the deadline
+    enqueue(&queue, 1);
+    enqueue(&queue, 2);
+    queue_deadline_in(&deadline, 20);
+    if (enqueue_timed(&queue, 3, &deadline) != QUEUE_TIMEOUT) {
+        safe_printf("enqueue_timed on full queue should time out\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+
+    // Closing rejects producers but lets consumers drain what is left
+    queue_close(&queue);
+    if (enqueue(&queue, 4) != QUEUE_CLOSED || enqueue_nonblocking(&queue, 4) != QUEUE_CLOSED) {
+        safe_printf("Enqueue on closed queue should fail with QUEUE_CLOSED\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+    if (dequeue(&queue, &item) != QUEUE_OK || item != 1 ||
+        dequeue(&queue, &item) != QUEUE_OK || item != 2 ||
+        dequeue(&queue, &item) != QUEUE_CLOSED) {
+        safe_printf("Closed queue did not drain correctly\n");
+        queue_destroy(&queue);
+        return -1;
+    }
+    queue_destroy(&queue);
+
+    // Blocked consumers exit promptly once producers are done and the queue closes
+    if (queue_init(&queue, QUEUE_CAPACITY) != 0) {
+        safe_printf("Failed to initialize queue\n");
+        return -1;
+    }
+
+    total_consumed = 0;
+    pthread_t consumers[NUM_CONSUMERS];
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        pthread_create(&consumers[i], NULL, closing_consumer_thread, &queue);
+    }
+
+    int expected = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+    for (int i = 0; i < expected; i++) {
+        enqueue(&queue, i);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    queue_close(&queue);
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    waited = elapsed_ms(&start);
+
+    bool success = total_consumed == expected;
+    safe_printf("Consumed %d/%d items, consumers stopped %ld ms after close\n",
+               total_consumed, expected, waited);
+    safe_printf("Timeouts and close test: %s\n", success ? "PASSED" : "FAILED");
+
+    queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Producer for the wait policy test: pushes a strictly increasing sequence
+ */
+void *policy_producer_thread(void *arg) {
+    ThreadSafeQueue *q = (ThreadSafeQueue *)arg;
+
+    for (int i = 0; i < POLICY_TEST_ITEMS; i++) {
+        enqueue(q, i);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Test that every wait policy preserves blocking semantics
+ */
+int test_wait_policies() {
+    safe_printf("\n=== Testing Wait Policies ===\n");
+
+    const QueueWaitPolicy policies[] = {
+        QUEUE_WAIT_BLOCK, QUEUE_WAIT_SPIN, QUEUE_WAIT_SPIN_YIELD, QUEUE_WAIT_ADAPTIVE
+    };
+    int failures = 0;
+
+    for (int p = 0; p < 4; p++) {
+        ThreadSafeQueue queue;
+        if (queue_init(&queue, 2) != 0 || queue_set_wait_policy(&queue, policies[p]) != 0) {
+            safe_printf("Failed to initialize queue with policy %s\n",
+                       queue_wait_policy_name(policies[p]));
+            return -1;
+        }
+
+        pthread_t producer;
+        pthread_create(&producer, NULL, policy_producer_thread, &queue);
+
+        int errors = 0;
+        for (int i = 0; i < POLICY_TEST_ITEMS; i++) {
+            int item;
+            if (dequeue(&queue, &item) != 0 || item != i) {
+                errors++;
+            }
+        }
+        pthread_join(producer, NULL);
+
+        safe_printf("Policy %-10s: %d items, %d out of order\n",
+                   queue_wait_policy_name(policies[p]), POLICY_TEST_ITEMS, errors);
+        if (errors != 0) {
+            failures++;
+        }
+        queue_destroy(&queue);
+    }
+
+    safe_printf("Wait policies test: %s\n", failures == 0 ? "PASSED" : "FAILED");
+    return failures == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Test heap allocation through queue_create() and the padded layout
+ */
+int test_queue_create() {
+    safe_printf("\n=== Testing Queue Create/Layout ===\n");
+
+    ThreadSafeQueue *queue = queue_create(QUEUE_CAPACITY);
+    if (queue == NULL) {
+        safe_printf("queue_create failed\n");
+        return -1;
+    }
+
+    bool aligned = ((uintptr_t)queue % QUEUE_CACHE_LINE) == 0;
+
+#ifndef QUEUE_PACKED_LAYOUT
+    // Producer and consumer state must not share a cache line
+    size_t producer_line = offsetof(ThreadSafeQueue, rear) / QUEUE_CACHE_LINE;
+    size_t consumer_line = offsetof(ThreadSafeQueue, front) / QUEUE_CACHE_LINE;
+    size_t lock_line = offsetof(ThreadSafeQueue, lock) / QUEUE_CACHE_LINE;
+    bool separated = producer_line != consumer_line &&
+                     producer_line != lock_line && consumer_line != lock_line;
+
+    // Each condvar sits whole on the line of the side that signals it
+    size_t not_empty_first = offsetof(ThreadSafeQueue, not_empty) / QUEUE_CACHE_LINE;
+    size_t not_empty_last = (offsetof(ThreadSafeQueue, not_empty) + sizeof(pthread_cond_t) - 1) /
+                            QUEUE_CACHE_LINE;
+    size_t not_full_first = offsetof(ThreadSafeQueue, not_full) / QUEUE_CACHE_LINE;
+    size_t not_full_last = (offsetof(ThreadSafeQueue, not_full) + sizeof(pthread_cond_t) - 1) /
+                           QUEUE_CACHE_LINE;
+    separated = separated && not_empty_first == producer_line && not_empty_last == producer_line &&
+                not_full_first == consumer_line && not_full_last == consumer_line;
+#else
+    bool separated = true;
+#endif
+
+    int item = 0;
+    bool works = enqueue(queue, 7) == 0 && dequeue(queue, &item) == 0 && item == 7;
+
+    queue_free(queue);
+
+    bool success = aligned && separated && works;
+    safe_printf("Aligned: %s, separated lines: %s, round trip: %s\n",
+               aligned ? "yes" : "no", separated ? "yes" : "no", works ? "yes" : "no");
+    safe_printf("Queue create test: %s\n", success ? "PASSED" : "FAILED");
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief SPSC producer: pushes a strictly increasing sequence
+ */
+void *spsc_producer_thread(void *arg) {
+    SpscQueue *q = (SpscQueue *)arg;
+
+    for (int i = 0; i < SPSC_TEST_ITEMS; i++) {
+        if (spsc_enqueue(q, i) != 0) {
+            safe_printf("SPSC producer failed to enqueue item %d\n", i);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Test the lock-free single-producer/single-consumer queue
+ */
+int test_spsc_queue() {
+    safe_printf("\n=== Testing SPSC Queue ===\n");
+
+    SpscQueue queue;
+    if (spsc_queue_init(&queue, 5) != 0) {
+        safe_printf("Failed to initialize SPSC queue\n");
+        return -1;
+    }
+
+    // Capacity is rounded up to a power of two
+    if (spsc_queue_capacity(&queue) != 8) {
+        safe_printf("Expected capacity 8, got %d\n", spsc_queue_capacity(&queue));
+        spsc_queue_destroy(&queue);
+        return -1;
+    }
+
+    // Fill to capacity, the next non-blocking enqueue must fail
+    for (int i = 0; i < 8; i++) {
+        if (spsc_enqueue_nonblocking(&queue, i) != 0) {
+            safe_printf("Failed to enqueue item %d\n", i);
+            spsc_queue_destroy(&queue);
+            return -1;
+        }
+    }
+    if (spsc_enqueue_nonblocking(&queue, 8) == 0) {
+        safe_printf("Enqueue on full SPSC queue should fail\n");
+        spsc_queue_destroy(&queue);
+        return -1;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        int item;
+        if (spsc_dequeue_nonblocking(&queue, &item) != 0 || item != i) {
+            safe_printf("SPSC FIFO order broken at item %d\n", i);
+            spsc_queue_destroy(&queue);
+            return -1;
+        }
+    }
+
+    int item;
+    if (spsc_dequeue_nonblocking(&queue, &item) == 0) {
+        safe_printf("Dequeue from empty SPSC queue should fail\n");
+        spsc_queue_destroy(&queue);
+        return -1;
+    }
+
+    // Concurrent handoff through a small ring forces both sides to block
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, spsc_producer_thread, &queue) != 0) {
+        safe_printf("Failed to create SPSC producer thread\n");
+        spsc_queue_destroy(&queue);
+        return -1;
+    }
+
+    int errors = 0;
+    for (int i = 0; i < SPSC_TEST_ITEMS; i++) {
+        if (spsc_dequeue(&queue, &item) != 0 || item != i) {
+            errors++;
+        }
+    }
+
+    pthread_join(producer, NULL);
+
+    bool success = errors == 0 && spsc_queue_size(&queue) == 0;
+    safe_printf("Transferred %d items, %d out of order\n", SPSC_TEST_ITEMS, errors);
+    safe_printf("SPSC queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    spsc_queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Arguments for MPMC test threads
+ */
+typedef struct {
+    MpmcQueue *queue;
+    int id;
+    long long sum;     // Sum of dequeued items (consumers)
+    int count;         // Number of dequeued items (consumers)
+    int order_errors;  // Per-producer FIFO violations seen (consumers)
+} MpmcTestArgs;
+
+void *mpmc_producer_thread(void *arg) {
+    MpmcTestArgs *args = (MpmcTestArgs *)arg;
+
+    for (int i = 0; i < MPMC_ITEMS_PER_PRODUCER; i++) {
+        mpmc_enqueue(args->queue, args->id * MPMC_ITEMS_PER_PRODUCER + i);
+    }
+
+    return NULL;
+}
+
+void *mpmc_consumer_thread(void *arg) {
+    MpmcTestArgs *args = (MpmcTestArgs *)arg;
+    int last_seen[MPMC_THREADS];
+
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        last_seen[i] = -1;
+    }
+
+    while (1) {
+        int item;
+        if (mpmc_dequeue(args->queue, &item) != 0) {
+            break;
+        }
+        if (item < 0) {
+            break; // Sentinel: no more items
+        }
+
+        // Items from one producer must come out in the order they went in
+        int producer = item / MPMC_ITEMS_PER_PRODUCER;
+        if (item <= last_seen[producer]) {
+            args->order_errors++;
+        }
+        last_seen[producer] = item;
+
+        args->sum += item;
+        args->count++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Test the lock-free multi-producer/multi-consumer queue
+ */
+int test_mpmc_queue() {
+    safe_printf("\n=== Testing MPMC Queue ===\n");
+
+    MpmcQueue queue;
+    if (mpmc_queue_init(&queue, QUEUE_CAPACITY) != 0) {
+        safe_printf("Failed to initialize MPMC queue\n");
+        return -1;
+    }
+
+    // Single-threaded sanity checks on a capacity rounded up to 8
+    for (int i = 0; i < 8; i++) {
+        if (mpmc_enqueue_nonblocking(&queue, i) != 0) {
+            safe_printf("Failed to enqueue item %d\n", i);
+            mpmc_queue_destroy(&queue);
+            return -1;
+        }
+    }
+    if (mpmc_enqueue_nonblocking(&queue, 8) == 0 || !mpmc_queue_is_full(&queue)) {
+        safe_printf("MPMC queue should report full\n");
+        mpmc_queue_destroy(&queue);
+        return -1;
+    }
+    for (int i = 0; i < 8; i++) {
+        int item;
+        if (mpmc_dequeue_nonblocking(&queue, &item) != 0 || item != i) {
+            safe_printf("MPMC FIFO order broken at item %d\n", i);
+            mpmc_queue_destroy(&queue);
+            return -1;
+        }
+    }
+    if (!mpmc_queue_is_empty(&queue)) {
+        safe_printf("MPMC queue should report empty\n");
+        mpmc_queue_destroy(&queue);
+        return -1;
+    }
+
+    pthread_t producers[MPMC_THREADS];
+    pthread_t consumers[MPMC_THREADS];
+    MpmcTestArgs producer_args[MPMC_THREADS];
+    MpmcTestArgs consumer_args[MPMC_THREADS];
+
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        consumer_args[i] = (MpmcTestArgs){&queue, i, 0, 0, 0};
+        pthread_create(&consumers[i], NULL, mpmc_consumer_thread, &consumer_args[i]);
+    }
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        producer_args[i] = (MpmcTestArgs){&queue, i, 0, 0, 0};
+        pthread_create(&producers[i], NULL, mpmc_producer_thread, &producer_args[i]);
+    }
+
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+
+    // One sentinel per consumer
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        mpmc_enqueue(&queue, -1);
+    }
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+
+    long long total = (long long)MPMC_THREADS * MPMC_ITEMS_PER_PRODUCER;
+    long long expected_sum = total * (total - 1) / 2;
+    long long sum = 0;
+    int count = 0;
+    int order_errors = 0;
+    for (int i = 0; i < MPMC_THREADS; i++) {
+        sum += consumer_args[i].sum;
+        count += consumer_args[i].count;
+        order_errors += consumer_args[i].order_errors;
+    }
+
+    bool success = count == total && sum == expected_sum && order_errors == 0;
+    safe_printf("Consumed %d/%lld items, checksum %s, %d order errors\n",
+               count, total, sum == expected_sum ? "OK" : "MISMATCH", order_errors);
+    safe_printf("MPMC queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    mpmc_queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Arguments for sharded queue test threads
+ */
+typedef struct {
+    ShardedQueue *queue;
+    int lane;
+    long long sum;
+    int count;
+    int wakeups;        // Times the idle consumer blocked
+} ShardedTestArgs;
+
+void *sharded_producer_thread(void *arg) {
+    ShardedTestArgs *args = (ShardedTestArgs *)arg;
+
+    for (int i = 0; i < SHARDED_ITEMS_PER_PRODUCER; i++) {
+        sharded_enqueue(args->queue, args->lane, args->lane * SHARDED_ITEMS_PER_PRODUCER + i);
+    }
+
+    return NULL;
+}
+
+void *sharded_consumer_thread(void *arg) {
+    ShardedTestArgs *args = (ShardedTestArgs *)arg;
+    int item;
+
+    while (sharded_dequeue(args->queue, args->lane, &item) == QUEUE_OK) {
+        args->sum += item;
+        args->count++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Consumer that records how often it went to sleep while idle
+ */
+void *sharded_idle_consumer_thread(void *arg) {
+    ShardedTestArgs *args = (ShardedTestArgs *)arg;
+    struct rusage before, after;
+    int item;
+
+    getrusage(RUSAGE_THREAD, &before);
+    if (sharded_dequeue(args->queue, args->lane, &item) == QUEUE_OK) {
+        args->sum = item;
+        args->count = 1;
+    }
+    getrusage(RUSAGE_THREAD, &after);
+
+    // Voluntary context switches: one per time the thread blocked
+    args->wakeups = (int)(after.ru_nvcsw - before.ru_nvcsw);
+    return NULL;
+}
+
+/**
+ * @brief Test the sharded multi-lane queue and consumer work stealing
+ */
+int test_sharded_queue() {
+    safe_printf("\n=== Testing Sharded Queue ===\n");
+
+    ShardedQueue queue;
+    if (sharded_queue_init(&queue, SHARDED_LANES, QUEUE_CAPACITY) != 0) {
+        safe_printf("Failed to initialize sharded queue\n");
+        return -1;
+    }
+
+    // An item on lane 0 must be stolen by a consumer whose home is lane 2
+    int item;
+    if (sharded_enqueue(&queue, 0, 99) != 0 || sharded_queue_size(&queue) != 1 ||
+        sharded_dequeue_nonblocking(&queue, 2, &item) != 0 || item != 99 ||
+        atomic_load(&queue.steals) != 1) {
+        safe_printf("Work stealing between lanes failed\n");
+        sharded_queue_destroy(&queue);
+        return -1;
+    }
+
+    // An idle consumer must sleep until an item arrives, even on another
+    // lane, instead of waking up periodically to rescan
+    pthread_t idle;
+    ShardedTestArgs idle_args = {&queue, SHARDED_LANES - 1, 0, 0, 0};
+    pthread_create(&idle, NULL, sharded_idle_consumer_thread, &idle_args);
+    usleep(SHARDED_IDLE_MS * 1000);
+    sharded_enqueue(&queue, 0, 42);
+    pthread_join(idle, NULL);
+    bool slept = idle_args.count == 1 && idle_args.sum == 42 && idle_args.wakeups <= 3;
+    safe_printf("Idle consumer: %d wakeups in %d ms\n", idle_args.wakeups, SHARDED_IDLE_MS);
+    if (!slept) {
+        safe_printf("Idle consumer did not sleep until the item arrived\n");
+        sharded_queue_destroy(&queue);
+        return -1;
+    }
+
+    // Producers only feed lanes 0..NUM_PRODUCERS-1; consumer homes are spread
+    // over all lanes so some of them can only make progress by stealing
+    pthread_t producers[NUM_PRODUCERS];
+    pthread_t consumers[NUM_CONSUMERS];
+    ShardedTestArgs producer_args[NUM_PRODUCERS];
+    ShardedTestArgs consumer_args[NUM_CONSUMERS];
+
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        consumer_args[i] = (ShardedTestArgs){&queue, SHARDED_LANES - 1 - i, 0, 0, 0};
+        pthread_create(&consumers[i], NULL, sharded_consumer_thread, &consumer_args[i]);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        producer_args[i] = (ShardedTestArgs){&queue, i, 0, 0, 0};
+        pthread_create(&producers[i], NULL, sharded_producer_thread, &producer_args[i]);
+    }
+
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    sharded_queue_close(&queue);
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+
+    long long total = (long long)NUM_PRODUCERS * SHARDED_ITEMS_PER_PRODUCER;
+    long long expected_sum = total * (total - 1) / 2;
+    long long sum = 0;
+    int count = 0;
+    for (int i = 0; i < NUM_CONSUMERS; i++) {
+        sum += consumer_args[i].sum;
+        count += consumer_args[i].count;
+    }
+
+    bool success = count == total && sum == expected_sum && sharded_queue_size(&queue) == 0;
+    safe_printf("Consumed %d/%lld items over %d lanes (%ld steals, %ld spills)\n",
+               count, total, SHARDED_LANES,
+               atomic_load(&queue.steals), atomic_load(&queue.spills));
+    safe_printf("Sharded queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    sharded_queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Producer for the priority test: item i goes to band i % PRIORITY_BANDS
+ */
+void *priority_producer_thread(void *arg) {
+    PriorityQueue *queue = (PriorityQueue *)arg;
+
+    for (int i = 0; i < PRIORITY_TEST_ITEMS; i++) {
+        priority_enqueue(queue, i, i % PRIORITY_BANDS);
+    }
+    priority_queue_close(queue);
+
+    return NULL;
+}
+
+/**
+ * @brief Test band ordering, blocking and close on the priority queue
+ */
+int test_priority_queue() {
+    safe_printf("\n=== Testing Priority Queue ===\n");
+
+    PriorityQueue queue;
+    if (priority_queue_init(&queue, QUEUE_CAPACITY) != 0) {
+        safe_printf("Failed to initialize priority queue\n");
+        return -1;
+    }
+
+    bool success = true;
+
+    // Urgent items overtake bulk ones; FIFO within a band
+    int pushes[][2] = {{10, 3}, {11, 3}, {20, 1}, {0, 0}, {21, 1}};
+    int expected[] = {0, 20, 21, 10, 11};
+    for (int i = 0; i < 5; i++) {
+        if (priority_enqueue(&queue, pushes[i][0], pushes[i][1]) != 0) {
+            success = false;
+        }
+    }
+    if (priority_enqueue_nonblocking(&queue, 99, 0) != QUEUE_ERROR ||
+        priority_enqueue(&queue, 99, PRIORITY_BANDS) != QUEUE_ERROR) {
+        safe_printf("Full queue or invalid priority accepted an item\n");
+        success = false;
+    }
+    for (int i = 0; i < 5; i++) {
+        int item, priority;
+        if (priority_dequeue(&queue, &item, &priority) != 0 || item != expected[i]) {
+            safe_printf("Expected %d at position %d\n", expected[i], i);
+            success = false;
+        }
+    }
+
+    // Concurrent traffic: every band must stay FIFO and nothing may be lost
+    pthread_t producer;
+    pthread_create(&producer, NULL, priority_producer_thread, &queue);
+
+    int last[PRIORITY_BANDS];
+    for (int b = 0; b < PRIORITY_BANDS; b++) {
+        last[b] = -1;
+    }
+
+    int item, priority, count = 0;
+    while (priority_dequeue(&queue, &item, &priority) == QUEUE_OK) {
+        if (priority != item % PRIORITY_BANDS || item <= last[priority]) {
+            success = false;
+        }
+        last[priority] = item;
+        count++;
+    }
+    pthread_join(producer, NULL);
+
+    if (count != PRIORITY_TEST_ITEMS || priority_queue_size(&queue) != 0) {
+        safe_printf("Consumed %d/%d items\n", count, PRIORITY_TEST_ITEMS);
+        success = false;
+    }
+
+    safe_printf("Priority queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    priority_queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Producer for the segmented test, pushes 0..SEGMENTED_BURST-1 then closes
+ */
+void *segmented_producer_thread(void *arg) {
+    SegmentedQueue *queue = (SegmentedQueue *)arg;
+
+    for (int i = 0; i < SEGMENTED_BURST; i++) {
+        segmented_enqueue(queue, i);
+    }
+    segmented_queue_close(queue);
+
+    return NULL;
+}
+
+/**
+ * @brief Test growth, segment recycling and the soft limit of the segmented queue
+ */
+int test_segmented_queue() {
+    safe_printf("\n=== Testing Segmented Queue ===\n");
+
+    SegmentedQueue queue;
+    if (segmented_queue_init(&queue, 0) != 0) {
+        safe_printf("Failed to initialize segmented queue\n");
+        return -1;
+    }
+
+    bool success = true;
+
+    // A burst far above MAX_QUEUE_SIZE never blocks and grows segment by segment
+    for (int i = 0; i < SEGMENTED_BURST; i++) {
+        if (segmented_enqueue_nonblocking(&queue, i) != 0) {
+            success = false;
+            break;
+        }
+    }
+    int grown = segmented_queue_segments(&queue);
+    if (segmented_queue_size(&queue) != SEGMENTED_BURST ||
+        grown != (SEGMENTED_BURST + SEGMENT_SIZE - 1) / SEGMENT_SIZE) {
+        safe_printf("Unexpected size or segment count after burst\n");
+        success = false;
+    }
+
+    // Draining returns segments; FIFO order holds across segment boundaries
+    int item;
+    for (int i = 0; i < SEGMENTED_BURST; i++) {
+        if (segmented_dequeue(&queue, &item) != 0 || item != i) {
+            success = false;
+            break;
+        }
+    }
+    if (segmented_queue_segments(&queue) != 1 ||
+        queue.num_spares != SEGMENTED_MAX_SPARES) {
+        safe_printf("Drained queue kept %d segments\n", segmented_queue_segments(&queue));
+        success = false;
+    }
+    segmented_queue_destroy(&queue);
+
+    // With a soft limit the producer is throttled but nothing is lost
+    if (segmented_queue_init(&queue, SEGMENTED_SOFT_LIMIT) != 0) {
+        safe_printf("Failed to initialize segmented queue\n");
+        return -1;
+    }
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, segmented_producer_thread, &queue);
+
+    int expected = 0;
+    while (segmented_dequeue(&queue, &item) == QUEUE_OK) {
+        if (item != expected || segmented_queue_size(&queue) > SEGMENTED_SOFT_LIMIT) {
+            success = false;
+        }
+        expected++;
+    }
+    pthread_join(producer, NULL);
+
+    if (expected != SEGMENTED_BURST ||
+        segmented_enqueue_nonblocking(&queue, 0) != QUEUE_CLOSED) {
+        safe_printf("Consumed %d/%d items\n", expected, SEGMENTED_BURST);
+        success = false;
+    }
+
+    safe_printf("Grew to %d segments for %d items\n", grown, SEGMENTED_BURST);
+    safe_printf("Segmented queue test: %s\n", success ? "PASSED" : "FAILED");
+
+    segmented_queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
+/**
+ * @brief Test the optional queue statistics
+ */
+int test_queue_stats() {
+    safe_printf("\n=== Testing Queue Statistics ===\n");
+
+    ThreadSafeQueue queue;
+    QueueStats stats;
+    if (queue_init(&queue, QUEUE_CAPACITY) != 0) {
+        safe_printf("Failed to initialize queue\n");
+        return -1;
+    }
+
+    bool success = true;
+
+    if (queue_get_stats(&queue, &stats) != -1 || queue_enable_stats(&queue) != 0) {
+        safe_printf("Statistics should start disabled and be enabled on request\n");
+        success = false;
+    }
+
+    // Fill, overflow once without blocking, drain, then time out once on empty
+    int item;
+    for (int i = 0; i < QUEUE_CAPACITY; i++) {
+        enqueue(&queue, i);
+    }
+    enqueue_nonblocking(&queue, 99);
+    for (int i = 0; i < QUEUE_CAPACITY; i++) {
+        dequeue(&queue, &item);
+    }
+    struct timespec deadline;
+    queue_deadline_in(&deadline, 20);
+    dequeue_timed(&queue, &item, &deadline);
+
+    queue_get_stats(&queue, &stats);
+    if (stats.enqueues != QUEUE_CAPACITY || stats.dequeues != QUEUE_CAPACITY ||
+        stats.high_water != QUEUE_CAPACITY || stats.blocked_empty != 1 ||
+        stats.blocked_full != 0 || stats.wait_ns_max < 10000000LL ||
+        stats.occupancy[QUEUE_STATS_BUCKETS - 1] != 1) {
+        safe_printf("Unexpected single-threaded statistics\n");
+        success = false;
+    }
+
+    // Concurrent traffic through the small queue: every op counted exactly once
+    pthread_t producer;
+    pthread_create(&producer, NULL, policy_producer_thread, &queue);
+    for (int i = 0; i < POLICY_TEST_ITEMS; i++) {
+        dequeue(&queue, &item);
+    }
+    pthread_join(producer, NULL);
+
+    queue_get_stats(&queue, &stats);
+    long long histogram = 0;
+    for (int b = 0; b < QUEUE_STATS_BUCKETS; b++) {
+        histogram += stats.occupancy[b];
+    }
+    if (stats.enqueues != QUEUE_CAPACITY + POLICY_TEST_ITEMS ||
+        stats.dequeues != stats.enqueues || histogram != stats.enqueues) {
+        safe_printf("Counters do not add up after concurrent traffic\n");
+        success = false;
+    }
+
+    safe_printf("enq=%lld deq=%lld blocked full/empty=%lld/%lld max wait=%lld us "
+               "contended=%lld high water=%lld\n",
+               stats.enqueues, stats.dequeues, stats.blocked_full, stats.blocked_empty,
+               stats.wait_ns_max / 1000, stats.contended, stats.high_water);
+    safe_printf("Queue statistics test: %s\n", success ? "PASSED" : "FAILED");
+
+    queue_destroy(&queue);
+    return success ? 0 : -1;
+}
+
 int main(int argc, char *argv[]) {
     safe_printf("Thread-Safe Queue Test Program\n");
     safe_printf("==============================\n");
@@ -291,17 +1346,69 @@ int main(int argc, char *argv[]) {
         safe_printf("Verbose mode enabled\n");
     }
     
-    // Initialize random seed
-    srand(time(NULL));
+    // Master seed for the per-thread PRNG; LAB_SEED=<seed> replays a run
+    safe_printf("Seed: %llu\n", (unsigned long long)prng_init_from_env());
     
+    int result = 0;
+
     // Run tests
-    test_basic_operations();
+    if (test_basic_operations() != 0) {
+        result = -1;
+    }
     test_multithreaded();
+
+    if (test_batch_operations() != 0) {
+        result = -1;
+    }
+
+    if (test_typed_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_timeouts_and_close() != 0) {
+        result = -1;
+    }
+
+    if (test_wait_policies() != 0) {
+        result = -1;
+    }
+
+    if (test_queue_create() != 0) {
+        result = -1;
+    }
+
+    if (test_spsc_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_mpmc_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_sharded_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_priority_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_segmented_queue() != 0) {
+        result = -1;
+    }
+
+    if (test_queue_stats() != 0) {
+        result = -1;
+    }
     
-    safe_printf("\nAll tests completed successfully!\n");
+    if (result == 0) {
+        safe_printf("\nAll tests completed successfully!\n");
+    } else {
+        safe_printf("\nSome tests failed\n");
+    }
     
     // Destroy printf lock
     pthread_mutex_destroy(&printf_lock);
     
-    return 0;
+    return result;
 }
\ No newline at end of file
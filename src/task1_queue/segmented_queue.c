@@ -0,0 +1,282 @@
+/**
+ * @file segmented_queue.c
+ * @brief Implementation of the unbounded segmented queue
+ */
+
+#include "segmented_queue.h"
+#include <stdlib.h>
+
+// Take a segment from the spares, allocating only when there is none
+static Segment *segment_get(SegmentedQueue *q) {
+    Segment *seg = q->spares;
+    if (seg != NULL) {
+        q->spares = seg->next;
+        q->num_spares--;
+    } else {
+        seg = malloc(sizeof(Segment));
+        if (seg == NULL) {
+            return NULL;
+        }
+    }
+
+    seg->next = NULL;
+    return seg;
+}
+
+// Return a drained segment to the spares, or free it if the pool is full
+static void segment_put(SegmentedQueue *q, Segment *seg) {
+    if (q->num_spares < SEGMENTED_MAX_SPARES) {
+        seg->next = q->spares;
+        q->spares = seg;
+        q->num_spares++;
+    } else {
+        free(seg);
+    }
+}
+
+static inline bool at_soft_limit(SegmentedQueue *q) {
+    return q->soft_limit > 0 && q->size >= q->soft_limit;
+}
+
+// Append an item (lock held); -1 if a new segment could not be allocated
+static int push_item(SegmentedQueue *q, int item) {
+    if (q->tail_idx == SEGMENT_SIZE) {
+        Segment *seg = segment_get(q);
+        if (seg == NULL) {
+            return -1;
+        }
+        q->tail->next = seg;
+        q->tail = seg;
+        q->tail_idx = 0;
+        q->num_segments++;
+    }
+
+    q->tail->items[q->tail_idx++] = item;
+    q->size++;
+    return 0;
+}
+
+// Remove the oldest item (lock held, queue not empty)
+static int pop_item(SegmentedQueue *q) {
+    int item = q->head->items[q->head_idx++];
+    q->size--;
+
+    if (q->head_idx == SEGMENT_SIZE) {
+        // Head segment fully read: release it, or rewind it when it is
+        // also the tail (the queue is then empty)
+        if (q->head->next != NULL) {
+            Segment *drained = q->head;
+            q->head = drained->next;
+            q->num_segments--;
+            segment_put(q, drained);
+        } else {
+            q->tail_idx = 0;
+        }
+        q->head_idx = 0;
+    } else if (q->size == 0) {
+        // Empty: rewind the single segment instead of walking to a new one
+        q->head_idx = 0;
+        q->tail_idx = 0;
+    }
+
+    return item;
+}
+
+int segmented_queue_init(SegmentedQueue *q, int soft_limit) {
+    if (q == NULL || soft_limit < 0) {
+        return -1;
+    }
+
+    q->spares = NULL;
+    q->num_spares = 0;
+
+    q->head = segment_get(q);
+    if (q->head == NULL) {
+        return -1;
+    }
+    q->tail = q->head;
+    q->head_idx = 0;
+    q->tail_idx = 0;
+    q->num_segments = 1;
+    q->size = 0;
+    q->soft_limit = soft_limit;
+    q->closed = false;
+
+    // Initialize mutex
+    if (pthread_mutex_init(&q->lock, NULL) != 0) {
+        free(q->head);
+        return -1;
+    }
+
+    // Initialize condition variables
+    if (pthread_cond_init(&q->not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        free(q->head);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_full, NULL) != 0) {
+        pthread_cond_destroy(&q->not_empty);
+        pthread_mutex_destroy(&q->lock);
+        free(q->head);
+        return -1;
+    }
+
+    return 0;
+}
+
+void segmented_queue_destroy(SegmentedQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+
+    while (q->head != NULL) {
+        Segment *next = q->head->next;
+        free(q->head);
+        q->head = next;
+    }
+    while (q->spares != NULL) {
+        Segment *next = q->spares->next;
+        free(q->spares);
+        q->spares = next;
+    }
+    q->tail = NULL;
+    q->num_spares = 0;
+    q->num_segments = 0;
+}
+
+int segmented_enqueue(SegmentedQueue *q, int item) {
+    if (q == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    // Backpressure only when a soft limit was configured
+    while (at_soft_limit(q) && !q->closed) {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+
+    int result = QUEUE_CLOSED;
+    if (!q->closed) {
+        result = push_item(q, item) == 0 ? QUEUE_OK : QUEUE_ERROR;
+        if (result == QUEUE_OK) {
+            // Signal that queue is not empty
+            pthread_cond_signal(&q->not_empty);
+        }
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int segmented_dequeue(SegmentedQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    // Wait while queue is empty; a closed queue is still drained first
+    while (q->size == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+
+    int result = QUEUE_CLOSED;
+    if (q->size > 0) {
+        *item = pop_item(q);
+        result = QUEUE_OK;
+
+        // Signal that queue is below the soft limit
+        if (q->soft_limit > 0) {
+            pthread_cond_signal(&q->not_full);
+        }
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int segmented_enqueue_nonblocking(SegmentedQueue *q, int item) {
+    if (q == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    int result = QUEUE_ERROR;
+    if (q->closed) {
+        result = QUEUE_CLOSED;
+    } else if (!at_soft_limit(q) && push_item(q, item) == 0) {
+        pthread_cond_signal(&q->not_empty);
+        result = QUEUE_OK;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int segmented_dequeue_nonblocking(SegmentedQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    int result = QUEUE_ERROR;
+    if (q->size > 0) {
+        *item = pop_item(q);
+        if (q->soft_limit > 0) {
+            pthread_cond_signal(&q->not_full);
+        }
+        result = QUEUE_OK;
+    } else if (q->closed) {
+        result = QUEUE_CLOSED;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+void segmented_queue_close(SegmentedQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+
+    // Every waiter has to re-evaluate its condition
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+
+    pthread_mutex_unlock(&q->lock);
+}
+
+int segmented_queue_size(SegmentedQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    int size = q->size;
+    pthread_mutex_unlock(&q->lock);
+
+    return size;
+}
+
+int segmented_queue_segments(SegmentedQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    int segments = q->num_segments;
+    pthread_mutex_unlock(&q->lock);
+
+    return segments;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file segmented_queue.h
+ * @brief Unbounded queue built from linked fixed-size segments
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Grows one segment at a time instead of reserving a fixed capacity up
+ * front, so memory tracks the actual occupancy. Drained segments go to a
+ * small pool of spares and are reused before anything new is allocated.
+ * An optional soft limit gives producers backpressure.
+ */
+
+#ifndef SEGMENTED_QUEUE_H
+#define SEGMENTED_QUEUE_H
+
+#include "thread_safe_queue.h"
+#include <stdbool.h>
+
+#define SEGMENT_SIZE 256        // Items per segment
+#define SEGMENTED_MAX_SPARES 4  // Drained segments kept for reuse, the rest are freed
+
+/**
+ * @brief Fixed-size chunk of the queue
+ */
+typedef struct Segment {
+    struct Segment *next; // Next (newer) segment, NULL for the tail
+    int items[SEGMENT_SIZE];
+} Segment;
+
+/**
+ * @brief Segmented queue structure
+ *
+ * Items are read from head->items[head_idx] and written to
+ * tail->items[tail_idx]. There is always at least one segment.
+ */
+typedef struct {
+    Segment *head;        // Oldest segment, consumers read from it
+    Segment *tail;        // Newest segment, producers write to it
+    int head_idx;         // Next index to read in head
+    int tail_idx;         // Next index to write in tail
+    Segment *spares;      // Recycled segments, linked through next
+    int num_spares;       // Length of the spares list
+    int num_segments;     // Segments currently linked into the queue
+    int size;             // Current number of elements
+    int soft_limit;       // Producers block at this size (0 = never block)
+    bool closed;          // Set by segmented_queue_close(), never cleared
+    pthread_mutex_t lock; // Mutex for thread safety
+    pthread_cond_t not_empty; // Condition variable for non-empty queue
+    pthread_cond_t not_full;  // Condition variable for size below the soft limit
+} SegmentedQueue;
+
+/**
+ * @brief Initialize a segmented queue
+ * @param q Pointer to the queue structure
+ * @param soft_limit Size at which enqueue blocks, 0 for an unbounded queue
+ * @return 0 on success, -1 on failure
+ */
+int segmented_queue_init(SegmentedQueue *q, int soft_limit);
+
+/**
+ * @brief Destroy a segmented queue and free every segment
+ * @param q Pointer to the queue structure
+ */
+void segmented_queue_destroy(SegmentedQueue *q);
+
+/**
+ * @brief Add an item, blocking only while the soft limit is reached
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @return 0 on success, -1 on failure (including out of memory), QUEUE_CLOSED if closed
+ */
+int segmented_enqueue(SegmentedQueue *q, int item);
+
+/**
+ * @brief Remove an item from the queue (blocks if empty)
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED once closed and drained
+ */
+int segmented_dequeue(SegmentedQueue *q, int *item);
+
+/**
+ * @brief Try to add an item without blocking
+ * @return 0 on success, -1 at the soft limit or on failure, QUEUE_CLOSED if closed
+ */
+int segmented_enqueue_nonblocking(SegmentedQueue *q, int item);
+
+/**
+ * @brief Try to remove an item without blocking
+ * @return 0 on success, -1 if empty or on failure, QUEUE_CLOSED once closed and drained
+ */
+int segmented_dequeue_nonblocking(SegmentedQueue *q, int *item);
+
+/**
+ * @brief Close the queue and wake every waiter
+ * @param q Pointer to the queue structure
+ */
+void segmented_queue_close(SegmentedQueue *q);
+
+/**
+ * @brief Get the current size of the queue
+ * @param q Pointer to the queue structure
+ * @return Current size, -1 on error
+ */
+int segmented_queue_size(SegmentedQueue *q);
+
+/**
+ * @brief Get the number of segments currently holding the queue
+ * @param q Pointer to the queue structure
+ * @return Linked segments (spares not included), -1 on error
+ */
+int segmented_queue_segments(SegmentedQueue *q);
+
+#endif // SEGMENTED_QUEUE_H
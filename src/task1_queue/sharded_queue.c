@@ -0,0 +1,200 @@
+/**
+ * @file sharded_queue.c
+ * @brief Implementation of the multi-lane work-stealing queue
+ */
+
+#include "sharded_queue.h"
+#include <stdlib.h>
+
+static inline int home_lane(ShardedQueue *sq, int lane) {
+    lane %= sq->num_lanes;
+    return lane < 0 ? lane + sq->num_lanes : lane;
+}
+
+// Destroy the first count lanes and free the array
+static void free_lanes(ShardedQueue *sq, int count) {
+    for (int i = 0; i < count; i++) {
+        queue_destroy(&sq->lanes[i]);
+    }
+    free(sq->lanes);
+    sq->lanes = NULL;
+}
+
+int sharded_queue_init(ShardedQueue *sq, int num_lanes, int lane_capacity) {
+    if (sq == NULL || num_lanes <= 0 || num_lanes > SHARDED_MAX_LANES || lane_capacity <= 0) {
+        return -1;
+    }
+
+    // Lanes are cache-line aligned, so plain malloc() is not enough
+    sq->lanes = aligned_alloc(_Alignof(ThreadSafeQueue), num_lanes * sizeof(ThreadSafeQueue));
+    if (sq->lanes == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < num_lanes; i++) {
+        if (queue_init(&sq->lanes[i], lane_capacity) != 0) {
+            free_lanes(sq, i);
+            return -1;
+        }
+    }
+
+    if (pthread_mutex_init(&sq->wait_lock, NULL) != 0) {
+        free_lanes(sq, num_lanes);
+        return -1;
+    }
+    if (pthread_cond_init(&sq->not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&sq->wait_lock);
+        free_lanes(sq, num_lanes);
+        return -1;
+    }
+
+    sq->num_lanes = num_lanes;
+    atomic_init(&sq->steals, 0);
+    atomic_init(&sq->spills, 0);
+    atomic_init(&sq->sleepers, 0);
+    return 0;
+}
+
+void sharded_queue_destroy(ShardedQueue *sq) {
+    if (sq == NULL || sq->lanes == NULL) {
+        return;
+    }
+
+    pthread_cond_destroy(&sq->not_empty);
+    pthread_mutex_destroy(&sq->wait_lock);
+    free_lanes(sq, sq->num_lanes);
+}
+
+/*
+ * Wake one sleeping consumer after an item was added. The item went in
+ * under its lane lock; a consumer registers in `sleepers` before its last
+ * scan, which also takes every lane lock, so either that scan sees the item
+ * or this load sees the sleeper.
+ */
+static void wake_consumer(ShardedQueue *sq) {
+    if (atomic_load(&sq->sleepers) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&sq->wait_lock);
+    pthread_cond_signal(&sq->not_empty);
+    pthread_mutex_unlock(&sq->wait_lock);
+}
+
+int sharded_enqueue(ShardedQueue *sq, int lane, int item) {
+    if (sq == NULL || sq->lanes == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    int home = home_lane(sq, lane);
+
+    // Try every lane once, starting at home, without blocking
+    for (int i = 0; i < sq->num_lanes; i++) {
+        int idx = (home + i) % sq->num_lanes;
+        int result = enqueue_nonblocking(&sq->lanes[idx], item);
+        if (result == QUEUE_OK) {
+            if (i > 0) {
+                atomic_fetch_add_explicit(&sq->spills, 1, memory_order_relaxed);
+            }
+            wake_consumer(sq);
+            return QUEUE_OK;
+        }
+        if (result == QUEUE_CLOSED) {
+            return QUEUE_CLOSED;
+        }
+    }
+
+    // Everything is full: wait for room on the home lane
+    int result = enqueue(&sq->lanes[home], item);
+    if (result == QUEUE_OK) {
+        wake_consumer(sq);
+    }
+    return result;
+}
+
+int sharded_dequeue_nonblocking(ShardedQueue *sq, int lane, int *item) {
+    if (sq == NULL || sq->lanes == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    int home = home_lane(sq, lane);
+    int closed_lanes = 0;
+
+    // Home lane first, then steal from the others in ring order
+    for (int i = 0; i < sq->num_lanes; i++) {
+        int idx = (home + i) % sq->num_lanes;
+        int result = dequeue_nonblocking(&sq->lanes[idx], item);
+        if (result == QUEUE_OK) {
+            if (i > 0) {
+                atomic_fetch_add_explicit(&sq->steals, 1, memory_order_relaxed);
+            }
+            return QUEUE_OK;
+        }
+        if (result == QUEUE_CLOSED) {
+            closed_lanes++;
+        }
+    }
+
+    return closed_lanes == sq->num_lanes ? QUEUE_CLOSED : QUEUE_ERROR;
+}
+
+int sharded_dequeue(ShardedQueue *sq, int lane, int *item) {
+    if (sq == NULL || sq->lanes == NULL || item == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    int home = home_lane(sq, lane);
+
+    for (;;) {
+        int result = sharded_dequeue_nonblocking(sq, home, item);
+        if (result != QUEUE_ERROR) {
+            return result;
+        }
+
+        // Nothing anywhere: register as a sleeper, scan once more (an item
+        // added before the registration is seen here, one added after it
+        // signals), then sleep until a producer or sharded_queue_close()
+        // wakes us. Producers need wait_lock to signal, so the signal cannot
+        // slip in between this scan and the wait.
+        pthread_mutex_lock(&sq->wait_lock);
+        atomic_fetch_add(&sq->sleepers, 1);
+        result = sharded_dequeue_nonblocking(sq, home, item);
+        if (result == QUEUE_ERROR) {
+            pthread_cond_wait(&sq->not_empty, &sq->wait_lock);
+        }
+        atomic_fetch_sub(&sq->sleepers, 1);
+        pthread_mutex_unlock(&sq->wait_lock);
+
+        if (result != QUEUE_ERROR) {
+            return result;
+        }
+    }
+}
+
+void sharded_queue_close(ShardedQueue *sq) {
+    if (sq == NULL || sq->lanes == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < sq->num_lanes; i++) {
+        queue_close(&sq->lanes[i]);
+    }
+
+    // Sleepers rescan, find every lane closed and drained, and return
+    pthread_mutex_lock(&sq->wait_lock);
+    pthread_cond_broadcast(&sq->not_empty);
+    pthread_mutex_unlock(&sq->wait_lock);
+}
+
+int sharded_queue_size(ShardedQueue *sq) {
+    if (sq == NULL || sq->lanes == NULL) {
+        return -1;
+    }
+
+    int total = 0;
+    for (int i = 0; i < sq->num_lanes; i++) {
+        total += queue_size(&sq->lanes[i]);
+    }
+
+    return total;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file sharded_queue.h
+ * @brief Multi-lane queue façade with work stealing for consumers
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Spreads traffic over an array of independent ThreadSafeQueue lanes (one per
+ * producer or per core) so there is no global lock. Producers push to their
+ * home lane; consumers pop from their home lane first and steal from the
+ * other lanes when it is empty.
+ */
+
+#ifndef SHARDED_QUEUE_H
+#define SHARDED_QUEUE_H
+
+#include "thread_safe_queue.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define SHARDED_MAX_LANES 256
+
+/**
+ * @brief Sharded queue structure
+ *
+ * Consumers that find every lane empty sleep on one shared condition
+ * variable instead of on a lane, since the next item may land anywhere.
+ * Producers only touch it when `sleepers` says someone is there, so the
+ * busy path never takes a global lock.
+ */
+typedef struct {
+    ThreadSafeQueue *lanes; // Array of num_lanes cache-aligned queues
+    int num_lanes;          // Number of lanes
+    atomic_long steals;     // Items taken from a lane other than the caller's home lane
+    atomic_long spills;     // Items pushed to another lane because the home lane was full
+    pthread_mutex_t wait_lock; // Guards sleeping on not_empty
+    pthread_cond_t not_empty;  // Signaled when an item arrives and someone sleeps
+    atomic_int sleepers;       // Consumers between their last scan and waking up
+} ShardedQueue;
+
+/**
+ * @brief Initialize a sharded queue
+ * @param sq Pointer to the sharded queue structure
+ * @param num_lanes Number of lanes (1..SHARDED_MAX_LANES)
+ * @param lane_capacity Capacity of each lane
+ * @return 0 on success, -1 on failure
+ */
+int sharded_queue_init(ShardedQueue *sq, int num_lanes, int lane_capacity);
+
+/**
+ * @brief Destroy a sharded queue and free resources
+ * @param sq Pointer to the sharded queue structure
+ */
+void sharded_queue_destroy(ShardedQueue *sq);
+
+/**
+ * @brief Add an item through the given home lane
+ *
+ * Uses the home lane if it has room, otherwise spills to the next lane with
+ * room; blocks on the home lane only when every lane is full.
+ *
+ * @param sq Pointer to the sharded queue structure
+ * @param lane Home lane of the caller (taken modulo num_lanes)
+ * @param item Item to add
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed
+ */
+int sharded_enqueue(ShardedQueue *sq, int lane, int item);
+
+/**
+ * @brief Remove an item, preferring the home lane and stealing otherwise
+ *
+ * Blocks while every lane is empty. Items from one lane keep their FIFO
+ * order; there is no ordering between lanes.
+ *
+ * @param sq Pointer to the sharded queue structure
+ * @param lane Home lane of the caller (taken modulo num_lanes)
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED once closed and drained
+ */
+int sharded_dequeue(ShardedQueue *sq, int lane, int *item);
+
+/**
+ * @brief Try to remove an item from any lane without blocking
+ * @param sq Pointer to the sharded queue structure
+ * @param lane Home lane of the caller (taken modulo num_lanes)
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 if every lane is empty, QUEUE_CLOSED once closed and drained
+ */
+int sharded_dequeue_nonblocking(ShardedQueue *sq, int lane, int *item);
+
+/**
+ * @brief Close every lane; consumers drain what is left and then get QUEUE_CLOSED
+ * @param sq Pointer to the sharded queue structure
+ */
+void sharded_queue_close(ShardedQueue *sq);
+
+/**
+ * @brief Get the total number of queued items
+ *
+ * Sums the lanes one after another without a global lock, so under
+ * concurrent traffic the result is approximate.
+ *
+ * @param sq Pointer to the sharded queue structure
+ * @return Aggregated size, -1 on error
+ */
+int sharded_queue_size(ShardedQueue *sq);
+
+#endif // SHARDED_QUEUE_H
@@ -0,0 +1,212 @@
+/**
+ * @file spsc_queue.c
+ * @brief Implementation of the lock-free single-producer/single-consumer queue
+ */
+
+#include "spsc_queue.h"
+#include <stdlib.h>
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static uint32_t round_up_pow2(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/*
+ * Wakeup handshake: the sleeper publishes its *_waiting flag and then
+ * re-reads the index; the waker publishes the index and then reads the flag.
+ * The seq_cst fences on both sides guarantee at least one of them sees the
+ * other's store, so a wakeup is never lost.
+ */
+static void wake_side(SpscQueue *q, atomic_int *waiting, pthread_cond_t *cond) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiting, memory_order_relaxed)) {
+        pthread_mutex_lock(&q->wait_lock);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&q->wait_lock);
+    }
+}
+
+int spsc_queue_init(SpscQueue *q, int capacity) {
+    if (q == NULL || capacity <= 0 || (uint32_t)capacity > SPSC_MAX_CAPACITY) {
+        return -1;
+    }
+
+    q->capacity = round_up_pow2((uint32_t)capacity);
+    q->mask = q->capacity - 1;
+
+    // Allocate memory for items
+    q->items = malloc(q->capacity * sizeof(int));
+    if (q->items == NULL) {
+        return -1;
+    }
+
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->cached_head = 0;
+    q->cached_tail = 0;
+    atomic_init(&q->consumer_waiting, 0);
+    atomic_init(&q->producer_waiting, 0);
+
+    if (pthread_mutex_init(&q->wait_lock, NULL) != 0) {
+        free(q->items);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&q->wait_lock);
+        free(q->items);
+        return -1;
+    }
+
+    if (pthread_cond_init(&q->not_full, NULL) != 0) {
+        pthread_cond_destroy(&q->not_empty);
+        pthread_mutex_destroy(&q->wait_lock);
+        free(q->items);
+        return -1;
+    }
+
+    return 0;
+}
+
+void spsc_queue_destroy(SpscQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    pthread_mutex_destroy(&q->wait_lock);
+
+    free(q->items);
+    q->items = NULL;
+}
+
+int spsc_enqueue_nonblocking(SpscQueue *q, int item) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Only refresh our view of head when the cached one says "full"
+    if (tail - q->cached_head == q->capacity) {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->cached_head == q->capacity) {
+            return -1;
+        }
+    }
+
+    q->items[tail & q->mask] = item;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+
+    wake_side(q, &q->consumer_waiting, &q->not_empty);
+    return 0;
+}
+
+int spsc_dequeue_nonblocking(SpscQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return -1;
+    }
+
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Only refresh our view of tail when the cached one says "empty"
+    if (head == q->cached_tail) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->cached_tail) {
+            return -1;
+        }
+    }
+
+    *item = q->items[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    wake_side(q, &q->producer_waiting, &q->not_full);
+    return 0;
+}
+
+int spsc_enqueue(SpscQueue *q, int item) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    for (;;) {
+        // Fast path plus a short spin before paying for a sleep
+        for (int spin = 0; spin < SPSC_SPIN_LIMIT; spin++) {
+            if (spsc_enqueue_nonblocking(q, item) == 0) {
+                return 0;
+            }
+            cpu_relax();
+        }
+
+        pthread_mutex_lock(&q->wait_lock);
+        atomic_store_explicit(&q->producer_waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        while (tail - atomic_load_explicit(&q->head, memory_order_acquire) == q->capacity) {
+            pthread_cond_wait(&q->not_full, &q->wait_lock);
+        }
+
+        atomic_store_explicit(&q->producer_waiting, 0, memory_order_relaxed);
+        pthread_mutex_unlock(&q->wait_lock);
+    }
+}
+
+int spsc_dequeue(SpscQueue *q, int *item) {
+    if (q == NULL || item == NULL) {
+        return -1;
+    }
+
+    for (;;) {
+        // Fast path plus a short spin before paying for a sleep
+        for (int spin = 0; spin < SPSC_SPIN_LIMIT; spin++) {
+            if (spsc_dequeue_nonblocking(q, item) == 0) {
+                return 0;
+            }
+            cpu_relax();
+        }
+
+        pthread_mutex_lock(&q->wait_lock);
+        atomic_store_explicit(&q->consumer_waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+        while (atomic_load_explicit(&q->tail, memory_order_acquire) == head) {
+            pthread_cond_wait(&q->not_empty, &q->wait_lock);
+        }
+
+        atomic_store_explicit(&q->consumer_waiting, 0, memory_order_relaxed);
+        pthread_mutex_unlock(&q->wait_lock);
+    }
+}
+
+int spsc_queue_size(SpscQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    // Read head first so that tail - head can never underflow
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return (int)(tail - head);
+}
+
+int spsc_queue_capacity(SpscQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+
+    return (int)q->capacity;
+}
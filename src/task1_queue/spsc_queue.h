@@ -0,0 +1,117 @@
+/**
+ * @file spsc_queue.h
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ * @author Ricardo Contreras Garzón
+ * @date 2025
+ *
+ * Variant of ThreadSafeQueue for pipes that have exactly one producer and
+ * one consumer. The hot path uses only C11 atomics on head/tail indices that
+ * live on separate cache lines; the mutex and condition variables are only
+ * touched when one side actually has to sleep.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SPSC_CACHE_LINE 64
+#define SPSC_MAX_CAPACITY (1u << 30)
+#define SPSC_SPIN_LIMIT 256
+
+/**
+ * @brief Single-producer/single-consumer queue structure
+ *
+ * Indices are free-running 32-bit counters; the slot is obtained by masking
+ * with (capacity - 1), so capacity is always a power of two.
+ */
+typedef struct {
+    // Read-only after initialization
+    _Alignas(SPSC_CACHE_LINE) int *items; // Array to store queue items
+    uint32_t mask;                        // capacity - 1
+    uint32_t capacity;                    // Maximum capacity (power of two)
+
+    // Consumer-owned line
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t head; // Next slot to read
+    uint32_t cached_tail;                 // Consumer's last view of tail
+
+    // Producer-owned line
+    _Alignas(SPSC_CACHE_LINE) _Atomic uint32_t tail; // Next slot to write
+    uint32_t cached_head;                 // Producer's last view of head
+
+    // Slow path, only used when a side has to block
+    _Alignas(SPSC_CACHE_LINE) atomic_int consumer_waiting;
+    atomic_int producer_waiting;
+    pthread_mutex_t wait_lock;            // Protects the sleep/wakeup handshake
+    pthread_cond_t not_empty;             // Consumer sleeps here
+    pthread_cond_t not_full;              // Producer sleeps here
+} SpscQueue;
+
+/**
+ * @brief Initialize an SPSC queue
+ * @param q Pointer to the queue structure
+ * @param capacity Requested capacity, rounded up to the next power of two
+ * @return 0 on success, -1 on failure
+ */
+int spsc_queue_init(SpscQueue *q, int capacity);
+
+/**
+ * @brief Destroy an SPSC queue and free resources
+ * @param q Pointer to the queue structure
+ */
+void spsc_queue_destroy(SpscQueue *q);
+
+/**
+ * @brief Add an item to the queue (blocking if full). Producer thread only.
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @return 0 on success, -1 on failure
+ */
+int spsc_enqueue(SpscQueue *q, int item);
+
+/**
+ * @brief Remove an item from the queue (blocking if empty). Consumer thread only.
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 on failure
+ */
+int spsc_dequeue(SpscQueue *q, int *item);
+
+/**
+ * @brief Try to add an item without blocking. Producer thread only.
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @return 0 on success, -1 if queue is full or error
+ */
+int spsc_enqueue_nonblocking(SpscQueue *q, int item);
+
+/**
+ * @brief Try to remove an item without blocking. Consumer thread only.
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @return 0 on success, -1 if queue is empty or error
+ */
+int spsc_dequeue_nonblocking(SpscQueue *q, int *item);
+
+/**
+ * @brief Get the number of queued items
+ *
+ * Safe to call from any thread; the value may be stale by the time it is
+ * returned if producer or consumer are running concurrently.
+ *
+ * @param q Pointer to the queue structure
+ * @return Current size, -1 on error
+ */
+int spsc_queue_size(SpscQueue *q);
+
+/**
+ * @brief Get the effective (power-of-two) capacity of the queue
+ * @param q Pointer to the queue structure
+ * @return Capacity, -1 on error
+ */
+int spsc_queue_capacity(SpscQueue *q);
+
+#endif // SPSC_QUEUE_H
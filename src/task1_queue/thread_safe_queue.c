@@ -3,27 +3,364 @@
  * @brief Implementation of thread-safe queue using mutex and condition variables
  */
 
+#define _DEFAULT_SOURCE
 #include "thread_safe_queue.h"
 #include <stdlib.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+
+// Number of online CPUs, sampled when a spinning policy is selected
+static atomic_long online_cpus = 1;
+
+// Statistics shard of the calling thread, assigned round-robin on first use
+static atomic_int next_stats_shard;
+static _Thread_local int stats_shard = -1;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * size is only written with the lock held, but spinning waiters and the
+ * queue_size()/queue_is_*() observers read it without the lock, so it is an
+ * atomic updated with relaxed stores.
+ */
+static inline void add_size(ThreadSafeQueue *q, int delta) {
+    int size = atomic_load_explicit(&q->size, memory_order_relaxed);
+    atomic_store_explicit(&q->size, size + delta, memory_order_relaxed);
+}
+
+static inline int peek_size(ThreadSafeQueue *q) {
+    return atomic_load_explicit(&q->size, memory_order_relaxed);
+}
+
+static inline QueueStatsShard *my_shard(ThreadSafeQueue *q) {
+    if (stats_shard < 0) {
+        stats_shard = atomic_fetch_add_explicit(&next_stats_shard, 1, memory_order_relaxed) %
+                      QUEUE_STATS_SHARDS;
+    }
+    return &q->stats[stats_shard];
+}
+
+static inline void stat_add(atomic_llong *counter, long long delta) {
+    atomic_fetch_add_explicit(counter, delta, memory_order_relaxed);
+}
+
+static inline void stat_max(atomic_llong *counter, long long value) {
+    long long cur = atomic_load_explicit(counter, memory_order_relaxed);
+    while (value > cur &&
+           !atomic_compare_exchange_weak_explicit(counter, &cur, value,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+// Count n enqueued (n > 0) or dequeued (n < 0) elements; lock held
+static void stats_count(ThreadSafeQueue *q, int n) {
+    if (q->stats == NULL) {
+        return;
+    }
+
+    QueueStatsShard *shard = my_shard(q);
+    if (n > 0) {
+        int size = peek_size(q);
+        long long bucket = (long long)size * QUEUE_STATS_BUCKETS / q->capacity;
+        if (bucket >= QUEUE_STATS_BUCKETS) {
+            bucket = QUEUE_STATS_BUCKETS - 1; // A full queue shares the top bucket
+        }
+        stat_add(&shard->enqueues, n);
+        stat_add(&shard->occupancy[bucket], n);
+        stat_max(&shard->high_water, size);
+    } else {
+        stat_add(&shard->dequeues, -n);
+    }
+}
+
+// Count a wait on not_full (full = true) or not_empty that began at started_ns
+static void stats_wait(ThreadSafeQueue *q, bool full, long long started_ns) {
+    if (q->stats == NULL) {
+        return;
+    }
+
+    QueueStatsShard *shard = my_shard(q);
+    long long waited = now_ns() - started_ns;
+    stat_add(full ? &shard->blocked_full : &shard->blocked_empty, 1);
+    stat_add(&shard->wait_ns_total, waited);
+    stat_max(&shard->wait_ns_max, waited);
+}
+
+/*
+ * Acquire the queue lock. With statistics enabled a trylock goes first so
+ * that acquisitions which found the lock taken can be counted.
+ */
+static inline void lock_queue(ThreadSafeQueue *q) {
+    if (q->stats == NULL) {
+        pthread_mutex_lock(&q->lock);
+        return;
+    }
+
+    if (pthread_mutex_trylock(&q->lock) != 0) {
+        stat_add(&my_shard(q)->contended, 1);
+        pthread_mutex_lock(&q->lock);
+    }
+}
+
+/*
+ * Wake consumers after `added` items became available. Consumers waiting in
+ * dequeue_batch() may need more than one item, so a single signal could land
+ * on one of them and be swallowed; broadcast whenever any of them is waiting.
+ */
+static void signal_not_empty(ThreadSafeQueue *q, int added) {
+    if (added > 1 || q->batch_waiters > 0) {
+        pthread_cond_broadcast(&q->not_empty);
+    } else {
+        pthread_cond_signal(&q->not_empty);
+    }
+}
+
+static void signal_not_full(ThreadSafeQueue *q, int freed) {
+    if (freed > 1) {
+        pthread_cond_broadcast(&q->not_full);
+    } else {
+        pthread_cond_signal(&q->not_full);
+    }
+}
+
+// Wait on cond until woken or deadline (NULL = forever); false once the deadline passed
+static bool wait_on(ThreadSafeQueue *q, pthread_cond_t *cond, const struct timespec *deadline) {
+    if (deadline == NULL) {
+        pthread_cond_wait(cond, &q->lock);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, &q->lock, deadline) != ETIMEDOUT;
+}
+
+/*
+ * Optimistic phase before parking, run with the lock released. Spins with
+ * pause (and for QUEUE_WAIT_SPIN_YIELD then yields the CPU) while size stays
+ * outside [min_size, max_size]. Returns with the lock held again either way;
+ * callers re-check their condition.
+ */
+static void spin_before_park(ThreadSafeQueue *q, int min_size, int max_size) {
+    int spins = 0;
+    int yields = 0;
+
+    switch (q->wait_policy) {
+        case QUEUE_WAIT_SPIN:
+            spins = QUEUE_SPIN_ITERATIONS;
+            break;
+        case QUEUE_WAIT_SPIN_YIELD:
+            spins = QUEUE_SPIN_ITERATIONS;
+            yields = QUEUE_YIELD_ITERATIONS;
+            break;
+        case QUEUE_WAIT_ADAPTIVE:
+            // Only worth burning CPU when recent waits were short and the
+            // other side can actually run in parallel
+            if (q->avg_wait_ns <= QUEUE_ADAPTIVE_SPIN_NS &&
+                atomic_load_explicit(&online_cpus, memory_order_relaxed) > 1) {
+                spins = QUEUE_SPIN_ITERATIONS;
+            }
+            break;
+        case QUEUE_WAIT_BLOCK:
+        default:
+            break;
+    }
+
+    if (spins == 0) {
+        return;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    for (int i = 0; i < spins + yields; i++) {
+        int size = peek_size(q);
+        if (size >= min_size && size <= max_size) {
+            break;
+        }
+        if (i < spins) {
+            cpu_relax();
+        } else {
+            sched_yield();
+        }
+    }
+
+    pthread_mutex_lock(&q->lock);
+}
+
+// Feed a completed wait into the moving average used by QUEUE_WAIT_ADAPTIVE
+static void record_wait(ThreadSafeQueue *q, long long started_ns) {
+    if (q->wait_policy == QUEUE_WAIT_ADAPTIVE) {
+        long long waited = now_ns() - started_ns;
+        q->avg_wait_ns += (waited - q->avg_wait_ns) / 8;
+    }
+}
+
+/*
+ * Wait (lock held) until there is room for one element.
+ * Returns QUEUE_OK, QUEUE_TIMEOUT or QUEUE_CLOSED.
+ */
+static int wait_not_full(ThreadSafeQueue *q, const struct timespec *deadline) {
+    if (q->size == q->capacity && !q->closed) {
+        long long started = q->wait_policy == QUEUE_WAIT_ADAPTIVE || q->stats ? now_ns() : 0;
+
+        spin_before_park(q, 0, q->capacity - 1);
+
+        while (q->size == q->capacity && !q->closed) {
+            if (!wait_on(q, &q->not_full, deadline) &&
+                q->size == q->capacity && !q->closed) {
+                stats_wait(q, true, started);
+                return QUEUE_TIMEOUT;
+            }
+        }
+
+        record_wait(q, started);
+        stats_wait(q, true, started);
+    }
+
+    return q->closed ? QUEUE_CLOSED : QUEUE_OK;
+}
+
+/*
+ * Wait (lock held) until at least min_items elements are queued. A closed
+ * queue still hands out whatever is left, and only reports QUEUE_CLOSED once
+ * it has been drained. Returns QUEUE_OK, QUEUE_TIMEOUT or QUEUE_CLOSED.
+ */
+static int wait_not_empty(ThreadSafeQueue *q, int min_items, const struct timespec *deadline) {
+    int result = QUEUE_OK;
+
+    if (q->size < min_items && !q->closed) {
+        long long started = q->wait_policy == QUEUE_WAIT_ADAPTIVE || q->stats ? now_ns() : 0;
+
+        spin_before_park(q, min_items, q->capacity);
+
+        if (min_items > 1) {
+            q->batch_waiters++;
+        }
+
+        while (q->size < min_items && !q->closed) {
+            if (!wait_on(q, &q->not_empty, deadline) &&
+                q->size < min_items && !q->closed) {
+                result = QUEUE_TIMEOUT;
+                break;
+            }
+        }
+
+        if (min_items > 1) {
+            q->batch_waiters--;
+        }
+
+        if (result == QUEUE_OK) {
+            record_wait(q, started);
+        }
+        stats_wait(q, false, started);
+    }
+
+    if (result == QUEUE_OK && q->size == 0 && q->closed) {
+        result = QUEUE_CLOSED;
+    }
+    return result;
+}
+
+// Address of the element stored at ring index idx
+static inline unsigned char *slot_at(ThreadSafeQueue *q, int idx) {
+    return q->items + (size_t)idx * q->elem_size;
+}
+
+// Copy n elements into the ring at rear, in at most two contiguous runs
+static void copy_in(ThreadSafeQueue *q, const void *elems, int n) {
+    int first = q->capacity - q->rear;
+    if (first > n) {
+        first = n;
+    }
+
+    const unsigned char *src = elems;
+    memcpy(slot_at(q, q->rear), src, first * q->elem_size);
+    memcpy(slot_at(q, 0), src + first * q->elem_size, (n - first) * q->elem_size);
+
+    q->rear = (q->rear + n) % q->capacity;
+    add_size(q, n);
+    stats_count(q, n);
+}
+
+// Copy n elements out of the ring from front, in at most two contiguous runs
+static void copy_out(ThreadSafeQueue *q, void *elems, int n) {
+    int first = q->capacity - q->front;
+    if (first > n) {
+        first = n;
+    }
+
+    unsigned char *dst = elems;
+    memcpy(dst, slot_at(q, q->front), first * q->elem_size);
+    memcpy(dst + first * q->elem_size, slot_at(q, 0), (n - first) * q->elem_size);
+
+    q->front = (q->front + n) % q->capacity;
+    add_size(q, -n);
+    stats_count(q, -n);
+}
+
+// The int convenience API is only for queues created as int queues; a
+// record queue of int size (e.g. float) is not one
+static inline bool holds_ints(ThreadSafeQueue *q) {
+    return q->int_api;
+}
 
 int queue_init(ThreadSafeQueue *q, int capacity) {
-    if (q == NULL || capacity <= 0) {
+    if (queue_init_typed(q, capacity, sizeof(int), _Alignof(int)) != 0) {
+        return -1;
+    }
+
+    q->int_api = true;
+    return 0;
+}
+
+int queue_init_typed(ThreadSafeQueue *q, int capacity, size_t elem_size, size_t elem_align) {
+    if (q == NULL || capacity <= 0 || elem_size == 0 ||
+        elem_align == 0 || (elem_align & (elem_align - 1)) != 0) {
+        return -1;
+    }
+
+    // Round the element stride up so every slot stays aligned
+    size_t stride = (elem_size + elem_align - 1) & ~(elem_align - 1);
+    if ((size_t)capacity > SIZE_MAX / stride) {
         return -1;
     }
 
-    // Allocate memory for items
-    q->items = malloc(capacity * sizeof(int));
+    // Allocate inline storage for the elements (aligned_alloc needs a multiple of the alignment)
+    size_t bytes = (size_t)capacity * stride;
+    bytes = (bytes + elem_align - 1) & ~(elem_align - 1);
+    q->items = aligned_alloc(elem_align, bytes);
     if (q->items == NULL) {
         return -1;
     }
 
     // Initialize queue properties
+    q->elem_size = stride;
+    q->elem_align = elem_align;
+    q->int_api = false;
     q->front = 0;
     q->rear = 0;
-    q->size = 0;
+    atomic_init(&q->size, 0);
     q->capacity = capacity;
+    q->batch_waiters = 0;
+    q->closed = false;
+    q->wait_policy = QUEUE_WAIT_BLOCK;
+    q->avg_wait_ns = 0;
+    q->stats = NULL;
 
     // Initialize mutex
     if (pthread_mutex_init(&q->lock, NULL) != 0) {
@@ -31,20 +368,32 @@ int queue_init(ThreadSafeQueue *q, int capacity) {
         return -1;
     }
 
+    // Condition variables time out against CLOCK_MONOTONIC deadlines
+    pthread_condattr_t attr;
+    if (pthread_condattr_init(&attr) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        free(q->items);
+        return -1;
+    }
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
     // Initialize condition variables
-    if (pthread_cond_init(&q->not_empty, NULL) != 0) {
+    if (pthread_cond_init(&q->not_empty, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
         pthread_mutex_destroy(&q->lock);
         free(q->items);
         return -1;
     }
 
-    if (pthread_cond_init(&q->not_full, NULL) != 0) {
+    if (pthread_cond_init(&q->not_full, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
         pthread_cond_destroy(&q->not_empty);
         pthread_mutex_destroy(&q->lock);
         free(q->items);
         return -1;
     }
 
+    pthread_condattr_destroy(&attr);
     return 0;
 }
 
@@ -63,104 +412,445 @@ void queue_destroy(ThreadSafeQueue *q) {
     // Free memory
     free(q->items);
     q->items = NULL;
+    free(q->stats);
+    q->stats = NULL;
 }
 
-int enqueue(ThreadSafeQueue *q, int item) {
+ThreadSafeQueue *queue_create(int capacity) {
+    ThreadSafeQueue *q = queue_create_typed(capacity, sizeof(int), _Alignof(int));
+    if (q != NULL) {
+        q->int_api = true;
+    }
+
+    return q;
+}
+
+ThreadSafeQueue *queue_create_typed(int capacity, size_t elem_size, size_t elem_align) {
+    // sizeof is already a multiple of the struct alignment, as aligned_alloc requires
+    ThreadSafeQueue *q = aligned_alloc(_Alignof(ThreadSafeQueue), sizeof(ThreadSafeQueue));
     if (q == NULL) {
+        return NULL;
+    }
+
+    if (queue_init_typed(q, capacity, elem_size, elem_align) != 0) {
+        free(q);
+        return NULL;
+    }
+
+    return q;
+}
+
+void queue_free(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    queue_destroy(q);
+    free(q);
+}
+
+int queue_set_wait_policy(ThreadSafeQueue *q, QueueWaitPolicy policy) {
+    if (q == NULL || policy < QUEUE_WAIT_BLOCK || policy > QUEUE_WAIT_ADAPTIVE) {
         return -1;
     }
 
+    atomic_store_explicit(&online_cpus, sysconf(_SC_NPROCESSORS_ONLN), memory_order_relaxed);
+
     pthread_mutex_lock(&q->lock);
+    q->wait_policy = policy;
+    q->avg_wait_ns = 0;
+    pthread_mutex_unlock(&q->lock);
 
-    // Wait while queue is full
-    while (q->size == q->capacity) {
-        pthread_cond_wait(&q->not_full, &q->lock);
+    return 0;
+}
+
+const char *queue_wait_policy_name(QueueWaitPolicy policy) {
+    switch (policy) {
+        case QUEUE_WAIT_BLOCK: return "block";
+        case QUEUE_WAIT_SPIN: return "spin";
+        case QUEUE_WAIT_SPIN_YIELD: return "spin-yield";
+        case QUEUE_WAIT_ADAPTIVE: return "adaptive";
+        default: return "unknown";
     }
+}
 
-    // Add item to queue
-    q->items[q->rear] = item;
-    q->rear = (q->rear + 1) % q->capacity;
-    q->size++;
+int queue_enable_stats(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return -1;
+    }
+    if (q->stats != NULL) {
+        return 0;
+    }
 
-    // Signal that queue is not empty
-    pthread_cond_signal(&q->not_empty);
-    
+    size_t bytes = QUEUE_STATS_SHARDS * sizeof(QueueStatsShard);
+    QueueStatsShard *shards = aligned_alloc(_Alignof(QueueStatsShard), bytes);
+    if (shards == NULL) {
+        return -1;
+    }
+    memset(shards, 0, bytes);
+
+    pthread_mutex_lock(&q->lock);
+    q->stats = shards;
     pthread_mutex_unlock(&q->lock);
+
     return 0;
 }
 
-int dequeue(ThreadSafeQueue *q, int *item) {
-    if (q == NULL || item == NULL) {
+int queue_get_stats(ThreadSafeQueue *q, QueueStats *stats) {
+    if (q == NULL || stats == NULL || q->stats == NULL) {
         return -1;
     }
 
+    memset(stats, 0, sizeof(*stats));
+
+    for (int i = 0; i < QUEUE_STATS_SHARDS; i++) {
+        QueueStatsShard *shard = &q->stats[i];
+        stats->enqueues += atomic_load_explicit(&shard->enqueues, memory_order_relaxed);
+        stats->dequeues += atomic_load_explicit(&shard->dequeues, memory_order_relaxed);
+        stats->blocked_full += atomic_load_explicit(&shard->blocked_full, memory_order_relaxed);
+        stats->blocked_empty += atomic_load_explicit(&shard->blocked_empty, memory_order_relaxed);
+        stats->wait_ns_total += atomic_load_explicit(&shard->wait_ns_total, memory_order_relaxed);
+        stats->contended += atomic_load_explicit(&shard->contended, memory_order_relaxed);
+
+        long long wait_max = atomic_load_explicit(&shard->wait_ns_max, memory_order_relaxed);
+        if (wait_max > stats->wait_ns_max) {
+            stats->wait_ns_max = wait_max;
+        }
+        long long high_water = atomic_load_explicit(&shard->high_water, memory_order_relaxed);
+        if (high_water > stats->high_water) {
+            stats->high_water = high_water;
+        }
+
+        for (int b = 0; b < QUEUE_STATS_BUCKETS; b++) {
+            stats->occupancy[b] += atomic_load_explicit(&shard->occupancy[b], memory_order_relaxed);
+        }
+    }
+
+    return 0;
+}
+
+void queue_close(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+
+    // Every waiter has to re-evaluate its condition
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+
+    pthread_mutex_unlock(&q->lock);
+}
+
+bool queue_is_closed(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return true;
+    }
+
     pthread_mutex_lock(&q->lock);
+    bool closed = q->closed;
+    pthread_mutex_unlock(&q->lock);
+
+    return closed;
+}
+
+void queue_deadline_in(struct timespec *deadline, long timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+int enqueue_elem_timed(ThreadSafeQueue *q, const void *elem, const struct timespec *deadline) {
+    if (q == NULL || elem == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    lock_queue(q);
+
+    // Wait while queue is full
+    int result = wait_not_full(q, deadline);
+    if (result == QUEUE_OK) {
+        // Add element to queue
+        copy_in(q, elem, 1);
+
+        // Signal that queue is not empty
+        signal_not_empty(q, 1);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int dequeue_elem_timed(ThreadSafeQueue *q, void *elem, const struct timespec *deadline) {
+    if (q == NULL || elem == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    lock_queue(q);
 
     // Wait while queue is empty
-    while (q->size == 0) {
-        pthread_cond_wait(&q->not_empty, &q->lock);
+    int result = wait_not_empty(q, 1, deadline);
+    if (result == QUEUE_OK) {
+        // Remove element from queue
+        copy_out(q, elem, 1);
+
+        // Signal that queue is not full
+        signal_not_full(q, 1);
     }
 
-    // Remove item from queue
-    *item = q->items[q->front];
-    q->front = (q->front + 1) % q->capacity;
-    q->size--;
+    pthread_mutex_unlock(&q->lock);
+    return result;
+}
+
+int enqueue_elem(ThreadSafeQueue *q, const void *elem) {
+    return enqueue_elem_timed(q, elem, NULL);
+}
+
+int dequeue_elem(ThreadSafeQueue *q, void *elem) {
+    return dequeue_elem_timed(q, elem, NULL);
+}
+
+int enqueue_elem_nonblocking(ThreadSafeQueue *q, const void *elem) {
+    if (q == NULL || elem == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    lock_queue(q);
+
+    // Check if queue is closed or full
+    if (q->closed || q->size == q->capacity) {
+        int result = q->closed ? QUEUE_CLOSED : QUEUE_ERROR;
+        pthread_mutex_unlock(&q->lock);
+        return result;
+    }
+
+    // Add element to queue
+    copy_in(q, elem, 1);
+
+    // Signal that queue is not empty
+    signal_not_empty(q, 1);
+
+    pthread_mutex_unlock(&q->lock);
+    return QUEUE_OK;
+}
+
+int dequeue_elem_nonblocking(ThreadSafeQueue *q, void *elem) {
+    if (q == NULL || elem == NULL) {
+        return QUEUE_ERROR;
+    }
+
+    lock_queue(q);
+
+    // Check if queue is empty (and, once closed, drained)
+    if (q->size == 0) {
+        int result = q->closed ? QUEUE_CLOSED : QUEUE_ERROR;
+        pthread_mutex_unlock(&q->lock);
+        return result;
+    }
+
+    // Remove element from queue
+    copy_out(q, elem, 1);
 
     // Signal that queue is not full
-    pthread_cond_signal(&q->not_full);
-    
+    signal_not_full(q, 1);
+
     pthread_mutex_unlock(&q->lock);
-    return 0;
+    return QUEUE_OK;
+}
+
+int enqueue(ThreadSafeQueue *q, int item) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return enqueue_elem_timed(q, &item, NULL);
+}
+
+int dequeue(ThreadSafeQueue *q, int *item) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return dequeue_elem_timed(q, item, NULL);
+}
+
+int enqueue_timed(ThreadSafeQueue *q, int item, const struct timespec *deadline) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return enqueue_elem_timed(q, &item, deadline);
+}
+
+int dequeue_timed(ThreadSafeQueue *q, int *item, const struct timespec *deadline) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return dequeue_elem_timed(q, item, deadline);
 }
 
 int enqueue_nonblocking(ThreadSafeQueue *q, int item) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return enqueue_elem_nonblocking(q, &item);
+}
+
+int dequeue_nonblocking(ThreadSafeQueue *q, int *item) {
+    if (q == NULL || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    return dequeue_elem_nonblocking(q, item);
+}
+
+void *queue_reserve_slot(ThreadSafeQueue *q) {
     if (q == NULL) {
-        return -1;
+        return NULL;
     }
 
-    pthread_mutex_lock(&q->lock);
+    lock_queue(q);
 
-    // Check if queue is full
-    if (q->size == q->capacity) {
+    // Wait while queue is full
+    if (wait_not_full(q, NULL) != QUEUE_OK) {
         pthread_mutex_unlock(&q->lock);
-        return -1;
+        return NULL;
     }
 
-    // Add item to queue
-    q->items[q->rear] = item;
+    // Lock stays held until queue_commit_slot()
+    return slot_at(q, q->rear);
+}
+
+void queue_commit_slot(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    // Publish the element written through queue_reserve_slot()
     q->rear = (q->rear + 1) % q->capacity;
-    q->size++;
+    add_size(q, 1);
+    stats_count(q, 1);
 
     // Signal that queue is not empty
-    pthread_cond_signal(&q->not_empty);
-    
+    signal_not_empty(q, 1);
+
     pthread_mutex_unlock(&q->lock);
-    return 0;
 }
 
-int dequeue_nonblocking(ThreadSafeQueue *q, int *item) {
-    if (q == NULL || item == NULL) {
-        return -1;
+const void *queue_peek_slot(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return NULL;
     }
 
-    pthread_mutex_lock(&q->lock);
+    lock_queue(q);
 
-    // Check if queue is empty
-    if (q->size == 0) {
+    // Wait while queue is empty
+    if (wait_not_empty(q, 1, NULL) != QUEUE_OK) {
         pthread_mutex_unlock(&q->lock);
-        return -1;
+        return NULL;
     }
 
-    // Remove item from queue
-    *item = q->items[q->front];
+    // Lock stays held until queue_release_slot()
+    return slot_at(q, q->front);
+}
+
+void queue_release_slot(ThreadSafeQueue *q) {
+    if (q == NULL) {
+        return;
+    }
+
+    // Drop the element read through queue_peek_slot()
     q->front = (q->front + 1) % q->capacity;
-    q->size--;
+    add_size(q, -1);
+    stats_count(q, -1);
 
     // Signal that queue is not full
-    pthread_cond_signal(&q->not_full);
-    
+    signal_not_full(q, 1);
+
     pthread_mutex_unlock(&q->lock);
-    return 0;
+}
+
+int enqueue_batch(ThreadSafeQueue *q, const int *items, int n) {
+    if (q == NULL || items == NULL || n < 0 || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    int done = 0;
+
+    lock_queue(q);
+
+    while (done < n) {
+        // Wait while queue is full
+        if (wait_not_full(q, NULL) != QUEUE_OK) {
+            break;
+        }
+
+        // Move as much as fits in one go
+        int chunk = q->capacity - q->size;
+        if (chunk > n - done) {
+            chunk = n - done;
+        }
+
+        copy_in(q, items + done, chunk);
+        done += chunk;
+
+        signal_not_empty(q, chunk);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    // Closed before anything could be added
+    if (done == 0 && n > 0) {
+        return QUEUE_CLOSED;
+    }
+    return done;
+}
+
+int dequeue_batch(ThreadSafeQueue *q, int *out, int max, int min_wait) {
+    if (q == NULL || out == NULL || max < 0 || min_wait < 0 || !holds_ints(q)) {
+        return QUEUE_ERROR;
+    }
+
+    // Never wait for more than could ever be handed out
+    if (min_wait > max) {
+        min_wait = max;
+    }
+
+    lock_queue(q);
+
+    if (min_wait > q->capacity) {
+        min_wait = q->capacity;
+    }
+
+    // Wait until enough items are available
+    if (min_wait > 0) {
+        wait_not_empty(q, min_wait, NULL);
+    }
+
+    // Closed and drained, whether or not we waited
+    if (q->size == 0 && q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        return QUEUE_CLOSED;
+    }
+
+    int count = q->size < max ? q->size : max;
+    copy_out(q, out, count);
+
+    if (count > 0) {
+        signal_not_full(q, count);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+    return count;
 }
 
 int queue_size(ThreadSafeQueue *q) {
@@ -168,11 +858,8 @@ int queue_size(ThreadSafeQueue *q) {
         return -1;
     }
 
-    pthread_mutex_lock(&q->lock);
-    int size = q->size;
-    pthread_mutex_unlock(&q->lock);
-    
-    return size;
+    // Lock-free: a relaxed read of the counter maintained under the lock
+    return peek_size(q);
 }
 
 bool queue_is_empty(ThreadSafeQueue *q) {
@@ -180,11 +867,7 @@ bool queue_is_empty(ThreadSafeQueue *q) {
         return true;
     }
 
-    pthread_mutex_lock(&q->lock);
-    bool empty = (q->size == 0);
-    pthread_mutex_unlock(&q->lock);
-    
-    return empty;
+    return peek_size(q) == 0;
 }
 
 bool queue_is_full(ThreadSafeQueue *q) {
@@ -192,9 +875,5 @@ bool queue_is_full(ThreadSafeQueue *q) {
         return false;
     }
 
-    pthread_mutex_lock(&q->lock);
-    bool full = (q->size == q->capacity);
-    pthread_mutex_unlock(&q->lock);
-    
-    return full;
-}
\ No newline at end of file
+    return peek_size(q) == q->capacity;
+}
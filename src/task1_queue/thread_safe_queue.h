@@ -9,22 +9,129 @@
 #define THREAD_SAFE_QUEUE_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
 
 #define MAX_QUEUE_SIZE 100
 
+// Status codes returned by queue operations
+#define QUEUE_OK 0
+#define QUEUE_ERROR -1    // Invalid argument, or full/empty for *_nonblocking
+#define QUEUE_TIMEOUT -2  // Deadline passed before the operation could proceed
+#define QUEUE_CLOSED -3   // Queue closed (and, for dequeues, fully drained)
+
+// Tuning for the spinning wait policies
+#define QUEUE_SPIN_ITERATIONS 2000   // pause iterations before yielding/parking
+#define QUEUE_YIELD_ITERATIONS 16    // sched_yield calls before parking
+#define QUEUE_ADAPTIVE_SPIN_NS 50000 // adaptive spins only while waits average below this
+
+/*
+ * ThreadSafeQueue keeps its fields on separate cache lines by who writes
+ * them. Each side's line holds its ring index and the condition variable
+ * it signals on every operation (a producer signals not_empty, a consumer
+ * not_full). The threads parked on a condvar only touch it when they
+ * sleep or wake. That only takes per-side traffic off the shared line:
+ * lock, size and closed are written by both sides on every operation and
+ * still move between cores, since a single mutex serializes everything.
+ * Building with -DQUEUE_PACKED_LAYOUT restores the packed layout for A/B
+ * comparisons (queue_bench vs queue_bench_packed).
+ */
+#define QUEUE_CACHE_LINE 64
+#ifdef QUEUE_PACKED_LAYOUT
+#define QUEUE_LINE_ALIGNED
+#else
+#define QUEUE_LINE_ALIGNED _Alignas(QUEUE_CACHE_LINE)
+#endif
+
+// Optional statistics (see queue_enable_stats())
+#define QUEUE_STATS_SHARDS 16  // Counter shards; threads are spread over them round-robin
+#define QUEUE_STATS_BUCKETS 8  // Occupancy histogram buckets, each 1/8 of the capacity
+
+/**
+ * @brief One shard of the statistics counters
+ *
+ * Each thread updates a single shard, so unrelated threads do not bounce
+ * the same cache line. Counters are relaxed atomics because several threads
+ * may share a shard when there are more than QUEUE_STATS_SHARDS of them.
+ */
+typedef struct {
+    QUEUE_LINE_ALIGNED atomic_llong enqueues;
+    atomic_llong dequeues;
+    atomic_llong blocked_full;   // Enqueues that had to wait for room
+    atomic_llong blocked_empty;  // Dequeues that had to wait for items
+    atomic_llong wait_ns_total;  // Time spent in those waits
+    atomic_llong wait_ns_max;
+    atomic_llong contended;      // Lock acquisitions that found the lock taken
+    atomic_llong high_water;     // Largest size seen after an enqueue
+    atomic_llong occupancy[QUEUE_STATS_BUCKETS];
+} QueueStatsShard;
+
+/**
+ * @brief Snapshot of the statistics, merged over all shards
+ */
+typedef struct {
+    long long enqueues;      // Elements added
+    long long dequeues;      // Elements removed
+    long long blocked_full;  // Times a producer waited on not_full
+    long long blocked_empty; // Times a consumer waited on not_empty
+    long long wait_ns_total; // Total time spent waiting, in nanoseconds
+    long long wait_ns_max;   // Longest single wait, in nanoseconds
+    long long contended;     // Operations that found the lock already taken
+    long long high_water;    // Maximum observed occupancy
+    long long occupancy[QUEUE_STATS_BUCKETS]; // Enqueues by resulting size, bucket i
+                                              // covering i/8..(i+1)/8 of the capacity
+} QueueStats;
+
+/**
+ * @brief How a thread waits when the queue is full or empty
+ *
+ * Every policy eventually parks on the condition variable, so none of them
+ * can spin forever; they only differ in what is tried first.
+ */
+typedef enum {
+    QUEUE_WAIT_BLOCK,      // Park on the condition variable immediately (default)
+    QUEUE_WAIT_SPIN,       // Bounded spin with pause, then park
+    QUEUE_WAIT_SPIN_YIELD, // Bounded spin, then sched_yield a few times, then park
+    QUEUE_WAIT_ADAPTIVE    // Spin only while recent waits have been short
+} QueueWaitPolicy;
+
 /**
  * @brief Thread-safe queue structure using circular buffer
+ *
+ * Elements are fixed-size records chosen at init time and stored inline in
+ * the ring. The int API (enqueue/dequeue/...) is available when the queue
+ * was created with queue_init().
+ *
+ * The structure is cache-line aligned; use queue_create() for heap
+ * allocation, since plain malloc() does not honor that alignment.
  */
 typedef struct {
-    int *items;           // Array to store queue items
-    int front;            // Index of front element
-    int rear;             // Index of rear element
-    int size;             // Current number of elements
+    // Read-mostly configuration
+    QUEUE_LINE_ALIGNED unsigned char *items; // Inline storage for capacity elements
+    size_t elem_size;     // Bytes per element slot (multiple of elem_align)
+    size_t elem_align;    // Alignment of each element slot
+    bool int_api;         // Created by queue_init()/queue_create(): holds ints
     int capacity;         // Maximum capacity
-    pthread_mutex_t lock; // Mutex for thread safety
-    pthread_cond_t not_empty; // Condition variable for non-empty queue
-    pthread_cond_t not_full;  // Condition variable for non-full queue
+    QueueWaitPolicy wait_policy; // Strategy used when full/empty
+    QueueStatsShard *stats; // QUEUE_STATS_SHARDS counter shards, NULL when disabled
+
+    // Shared state, written by both sides under the lock (this line still
+    // bounces on every operation)
+    QUEUE_LINE_ALIGNED pthread_mutex_t lock; // Mutex for thread safety
+    atomic_int size;      // Current number of elements (written under lock)
+    int batch_waiters;    // Consumers waiting for more than one item
+    bool closed;          // Set by queue_close(), never cleared
+    long long avg_wait_ns; // Moving average of wait time (adaptive policy)
+
+    // Producer side: written by enqueues
+    QUEUE_LINE_ALIGNED int rear; // Index of rear element
+    pthread_cond_t not_empty;    // Signaled by producers, waited on by consumers
+
+    // Consumer side: written by dequeues
+    QUEUE_LINE_ALIGNED int front; // Index of front element
+    pthread_cond_t not_full;      // Signaled by consumers, waited on by producers
 } ThreadSafeQueue;
 
 /**
@@ -35,17 +142,115 @@ typedef struct {
  */
 int queue_init(ThreadSafeQueue *q, int capacity);
 
+/**
+ * @brief Initialize a thread-safe queue of fixed-size records
+ * @param q Pointer to the queue structure
+ * @param capacity Maximum capacity of the queue
+ * @param elem_size Size in bytes of each element
+ * @param elem_align Alignment of each element (power of two, e.g. _Alignof(T))
+ * @return 0 on success, -1 on failure
+ */
+int queue_init_typed(ThreadSafeQueue *q, int capacity, size_t elem_size, size_t elem_align);
+
 /**
  * @brief Destroy a thread-safe queue and free resources
  * @param q Pointer to the queue structure
  */
 void queue_destroy(ThreadSafeQueue *q);
 
+/**
+ * @brief Allocate and initialize a cache-line aligned int queue
+ * @param capacity Maximum capacity of the queue
+ * @return New queue, NULL on failure. Release with queue_free().
+ */
+ThreadSafeQueue *queue_create(int capacity);
+
+/**
+ * @brief Allocate and initialize a cache-line aligned queue of fixed-size records
+ * @param capacity Maximum capacity of the queue
+ * @param elem_size Size in bytes of each element
+ * @param elem_align Alignment of each element (power of two)
+ * @return New queue, NULL on failure. Release with queue_free().
+ */
+ThreadSafeQueue *queue_create_typed(int capacity, size_t elem_size, size_t elem_align);
+
+/**
+ * @brief Destroy and deallocate a queue obtained from queue_create()
+ * @param q Pointer to the queue structure
+ */
+void queue_free(ThreadSafeQueue *q);
+
+/**
+ * @brief Select how blocked operations wait
+ *
+ * Meant to be called right after initialization, before other threads start
+ * using the queue.
+ *
+ * @param q Pointer to the queue structure
+ * @param policy Wait policy to use
+ * @return 0 on success, -1 on failure
+ */
+int queue_set_wait_policy(ThreadSafeQueue *q, QueueWaitPolicy policy);
+
+/**
+ * @brief Get a printable name for a wait policy
+ * @param policy Wait policy
+ * @return Static string
+ */
+const char *queue_wait_policy_name(QueueWaitPolicy policy);
+
+/**
+ * @brief Start collecting statistics for the queue
+ *
+ * Like queue_set_wait_policy(), call it before other threads start using
+ * the queue. Disabled queues pay a single NULL check per operation.
+ *
+ * @param q Pointer to the queue structure
+ * @return 0 on success (or if already enabled), -1 on failure
+ */
+int queue_enable_stats(ThreadSafeQueue *q);
+
+/**
+ * @brief Take a snapshot of the statistics
+ *
+ * Shards are read one after another without stopping the queue, so under
+ * concurrent traffic the counters may be slightly out of step with each other.
+ *
+ * @param q Pointer to the queue structure
+ * @param stats Output snapshot
+ * @return 0 on success, -1 on failure or if statistics are disabled
+ */
+int queue_get_stats(ThreadSafeQueue *q, QueueStats *stats);
+
+/**
+ * @brief Close the queue and wake every blocked thread
+ *
+ * After closing, enqueues fail with QUEUE_CLOSED and dequeues keep returning
+ * the remaining items until the queue is drained, then fail with QUEUE_CLOSED.
+ *
+ * @param q Pointer to the queue structure
+ */
+void queue_close(ThreadSafeQueue *q);
+
+/**
+ * @brief Check if queue_close() has been called
+ * @param q Pointer to the queue structure
+ * @return true if closed, false otherwise
+ */
+bool queue_is_closed(ThreadSafeQueue *q);
+
+/**
+ * @brief Compute a CLOCK_MONOTONIC deadline timeout_ms from now
+ * @param deadline Output deadline for the *_timed operations
+ * @param timeout_ms Relative timeout in milliseconds
+ */
+void queue_deadline_in(struct timespec *deadline, long timeout_ms);
+
 /**
  * @brief Add an item to the queue (blocking if full)
  * @param q Pointer to the queue structure
  * @param item Item to add
- * @return 0 on success, -1 on failure
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed
  */
 int enqueue(ThreadSafeQueue *q, int item);
 
@@ -53,15 +258,33 @@ int enqueue(ThreadSafeQueue *q, int item);
  * @brief Remove an item from the queue (blocking if empty)
  * @param q Pointer to the queue structure
  * @param item Pointer to store the removed item
- * @return 0 on success, -1 on failure
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed and drained
  */
 int dequeue(ThreadSafeQueue *q, int *item);
 
+/**
+ * @brief Add an item, blocking while full until an absolute deadline
+ * @param q Pointer to the queue structure
+ * @param item Item to add
+ * @param deadline Absolute CLOCK_MONOTONIC deadline (NULL waits forever)
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT or QUEUE_CLOSED
+ */
+int enqueue_timed(ThreadSafeQueue *q, int item, const struct timespec *deadline);
+
+/**
+ * @brief Remove an item, blocking while empty until an absolute deadline
+ * @param q Pointer to the queue structure
+ * @param item Pointer to store the removed item
+ * @param deadline Absolute CLOCK_MONOTONIC deadline (NULL waits forever)
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT or QUEUE_CLOSED
+ */
+int dequeue_timed(ThreadSafeQueue *q, int *item, const struct timespec *deadline);
+
 /**
  * @brief Try to add an item without blocking
  * @param q Pointer to the queue structure
  * @param item Item to add
- * @return 0 on success, -1 if queue is full or error
+ * @return 0 on success, -1 if queue is full or error, QUEUE_CLOSED if closed
  */
 int enqueue_nonblocking(ThreadSafeQueue *q, int item);
 
@@ -69,26 +292,152 @@ int enqueue_nonblocking(ThreadSafeQueue *q, int item);
  * @brief Try to remove an item without blocking
  * @param q Pointer to the queue structure
  * @param item Pointer to store the removed item
- * @return 0 on success, -1 if queue is empty or error
+ * @return 0 on success, -1 if queue is empty or error, QUEUE_CLOSED if closed and drained
  */
 int dequeue_nonblocking(ThreadSafeQueue *q, int *item);
 
 /**
- * @brief Get current size of the queue (thread-safe)
+ * @brief Copy an element into the queue (blocking if full)
+ * @param q Pointer to the queue structure
+ * @param elem Element of the size given at init
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed
+ */
+int enqueue_elem(ThreadSafeQueue *q, const void *elem);
+
+/**
+ * @brief Copy an element out of the queue (blocking if empty)
+ * @param q Pointer to the queue structure
+ * @param elem Buffer of the size given at init
+ * @return 0 on success, -1 on failure, QUEUE_CLOSED if closed and drained
+ */
+int dequeue_elem(ThreadSafeQueue *q, void *elem);
+
+/**
+ * @brief Copy an element into the queue, blocking while full until a deadline
+ * @param q Pointer to the queue structure
+ * @param elem Element of the size given at init
+ * @param deadline Absolute CLOCK_MONOTONIC deadline (NULL waits forever)
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT or QUEUE_CLOSED
+ */
+int enqueue_elem_timed(ThreadSafeQueue *q, const void *elem, const struct timespec *deadline);
+
+/**
+ * @brief Copy an element out of the queue, blocking while empty until a deadline
+ * @param q Pointer to the queue structure
+ * @param elem Buffer of the size given at init
+ * @param deadline Absolute CLOCK_MONOTONIC deadline (NULL waits forever)
+ * @return 0 on success, -1 on failure, QUEUE_TIMEOUT or QUEUE_CLOSED
+ */
+int dequeue_elem_timed(ThreadSafeQueue *q, void *elem, const struct timespec *deadline);
+
+/**
+ * @brief Try to copy an element into the queue without blocking
+ * @param q Pointer to the queue structure
+ * @param elem Element of the size given at init
+ * @return 0 on success, -1 if queue is full or error, QUEUE_CLOSED if closed
+ */
+int enqueue_elem_nonblocking(ThreadSafeQueue *q, const void *elem);
+
+/**
+ * @brief Try to copy an element out of the queue without blocking
+ * @param q Pointer to the queue structure
+ * @param elem Buffer of the size given at init
+ * @return 0 on success, -1 if queue is empty or error, QUEUE_CLOSED if closed and drained
+ */
+int dequeue_elem_nonblocking(ThreadSafeQueue *q, void *elem);
+
+/**
+ * @brief Reserve the next free slot for in-place writing (blocking if full)
+ *
+ * Returns a pointer into queue memory so the producer can build the element
+ * without an intermediate copy. The queue lock is held until
+ * queue_commit_slot(), which must be called from the same thread without
+ * calling any other queue function in between.
+ *
+ * @param q Pointer to the queue structure
+ * @return Pointer to the slot, NULL on error or if the queue is closed
+ */
+void *queue_reserve_slot(ThreadSafeQueue *q);
+
+/**
+ * @brief Publish the slot obtained with queue_reserve_slot()
+ * @param q Pointer to the queue structure
+ */
+void queue_commit_slot(ThreadSafeQueue *q);
+
+/**
+ * @brief Access the oldest element in place (blocking if empty)
+ *
+ * The queue lock is held until queue_release_slot(), which must be called
+ * from the same thread without calling any other queue function in between.
+ *
+ * @param q Pointer to the queue structure
+ * @return Pointer to the element, NULL on error or if closed and drained
+ */
+const void *queue_peek_slot(ThreadSafeQueue *q);
+
+/**
+ * @brief Remove the element obtained with queue_peek_slot()
+ * @param q Pointer to the queue structure
+ */
+void queue_release_slot(ThreadSafeQueue *q);
+
+/**
+ * @brief Add several items, copying as many as fit under a single lock hold
+ *
+ * Blocks while the queue is full. When n exceeds the free space the items are
+ * moved in several chunks, so the batch is only atomic per chunk with respect
+ * to other producers. Each chunk issues a single wakeup. Requires a queue
+ * created with queue_init().
+ *
+ * @param q Pointer to the queue structure
+ * @param items Items to add, in FIFO order
+ * @param n Number of items
+ * @return Number of items added (less than n if the queue was closed midway),
+ *         -1 on failure, QUEUE_CLOSED if closed before anything was added
+ */
+int enqueue_batch(ThreadSafeQueue *q, const int *items, int n);
+
+/**
+ * @brief Remove up to max items under a single lock hold
+ *
+ * Blocks until at least min_wait items are available (clamped to max and to
+ * the queue capacity); min_wait of 0 never blocks. Requires a queue created
+ * with queue_init().
+ *
+ * @param q Pointer to the queue structure
+ * @param out Buffer receiving the removed items, in FIFO order
+ * @param max Capacity of out
+ * @param min_wait Minimum number of items to wait for
+ * @return Number of items removed (a closed queue returns what is left even
+ *         if fewer than min_wait), -1 on failure, QUEUE_CLOSED if closed and
+ *         drained (also with min_wait of 0, so polling callers see the end)
+ */
+int dequeue_batch(ThreadSafeQueue *q, int *out, int max, int min_wait);
+
+/**
+ * @brief Get current size of the queue without taking the lock
+ *
+ * Observers never touch q->lock, so polling them does not contend with
+ * producers and consumers. The value is a relaxed snapshot: it is always a
+ * size the queue really had, but it may already be stale on return and it
+ * does not order any other memory access. Use it for monitoring and
+ * heuristics, not to decide whether a following dequeue will succeed.
+ *
  * @param q Pointer to the queue structure
  * @return Current size, -1 on error
  */
 int queue_size(ThreadSafeQueue *q);
 
 /**
- * @brief Check if queue is empty (thread-safe)
+ * @brief Check if queue is empty (lock-free relaxed snapshot, see queue_size())
  * @param q Pointer to the queue structure
  * @return true if empty, false otherwise
  */
 bool queue_is_empty(ThreadSafeQueue *q);
 
 /**
- * @brief Check if queue is full (thread-safe)
+ * @brief Check if queue is full (lock-free relaxed snapshot, see queue_size())
  * @param q Pointer to the queue structure
  * @return true if full, false otherwise
  */
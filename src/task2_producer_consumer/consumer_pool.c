@@ -0,0 +1,210 @@
+#define _DEFAULT_SOURCE
+#include "consumer_pool.h"
+#include <stdio.h>
+#include <unistd.h>
+
+void pc_pool_default_options(PcPoolOptions *options) {
+    options->min_consumers = 1;
+    options->max_consumers = 4;
+    options->high_watermark = 0.75;
+    options->low_watermark = 0.25;
+    options->grow_samples = 2;
+    options->shrink_samples = 10;
+    options->sample_ms = 10;
+    options->batch = 1;
+    options->consume = NULL;
+    options->ctx = NULL;
+}
+
+static void *pool_consumer(void *arg) {
+    PcPoolSlot *slot = (PcPoolSlot *)arg;
+    PcConsumerPool *pool = slot->pool;
+    ProducerConsumerBuffer *buffer = pool->buffer;
+    const PcPoolOptions *options = &pool->options;
+
+    TRACE(TRACE_INFO, TRACE_CONSUMER_START, slot->id, 0, -1);
+
+    int items[PC_MAX_BATCH];
+    long long stamps[PC_MAX_BATCH];
+    while (!atomic_load(&slot->retire)) {
+        int taken = buffer_get_timed(buffer, items, stamps, options->batch, options->sample_ms);
+        if (taken < 0) {
+            // Cerrado y vacío: el resto de los consumidores sale en cascada
+            atomic_store(&pool->finished, true);
+            break;
+        }
+
+        for (int j = 0; j < taken; j++) {
+            if (slot->latency) {
+                latency_histogram_record(slot->latency->queue_delay, latency_now_ns() - stamps[j]);
+            }
+
+            if (options->consume) {
+                options->consume(options->ctx, slot->id, items[j]);
+            } else {
+                consume_item(items[j], slot->id);
+            }
+
+            if (slot->latency) {
+                latency_histogram_record(slot->latency->end_to_end, latency_now_ns() - stamps[j]);
+            }
+        }
+    }
+
+    TRACE(TRACE_INFO, TRACE_CONSUMER_END, slot->id, 0, -1);
+    atomic_store(&slot->state, PC_POOL_SLOT_EXITED);
+    return NULL;
+}
+
+// Join de los hilos que ya terminaron, dejando su lugar libre
+static void reap_slots(PcConsumerPool *pool) {
+    for (int i = 0; i < pool->options.max_consumers; i++) {
+        PcPoolSlot *slot = &pool->slots[i];
+        if (atomic_load(&slot->state) == PC_POOL_SLOT_EXITED) {
+            pthread_join(slot->thread, NULL);
+            atomic_store(&slot->state, PC_POOL_SLOT_FREE);
+        }
+    }
+}
+
+// Lanzar un consumidor en el primer lugar libre; 0 o -1
+static int spawn_consumer(PcConsumerPool *pool) {
+    for (int i = 0; i < pool->options.max_consumers; i++) {
+        PcPoolSlot *slot = &pool->slots[i];
+        if (atomic_load(&slot->state) != PC_POOL_SLOT_FREE) continue;
+
+        if (!slot->latency) {
+            slot->latency = register_consumer_latency(pool->buffer);
+        }
+        atomic_store(&slot->retire, false);
+        atomic_store(&slot->state, PC_POOL_SLOT_RUNNING);
+        if (pthread_create(&slot->thread, NULL, pool_consumer, slot) != 0) {
+            perror("Error creando consumidor del grupo");
+            atomic_store(&slot->state, PC_POOL_SLOT_FREE);
+            return -1;
+        }
+
+        int active = atomic_fetch_add(&pool->active, 1) + 1;
+        if (active > atomic_load(&pool->peak)) atomic_store(&pool->peak, active);
+        pool->spawned++;
+        return 0;
+    }
+    return -1;
+}
+
+// Retirar el consumidor activo de mayor índice
+static void retire_consumer(PcConsumerPool *pool) {
+    for (int i = pool->options.max_consumers - 1; i >= 0; i--) {
+        PcPoolSlot *slot = &pool->slots[i];
+        if (atomic_load(&slot->state) == PC_POOL_SLOT_RUNNING && !atomic_load(&slot->retire)) {
+            atomic_store(&slot->retire, true);
+            atomic_fetch_sub(&pool->active, 1);
+            pool->retired++;
+            return;
+        }
+    }
+}
+
+static void *pool_controller(void *arg) {
+    PcConsumerPool *pool = (PcConsumerPool *)arg;
+    const PcPoolOptions *options = &pool->options;
+    ProducerConsumerBuffer *buffer = pool->buffer;
+    int above = 0;
+    int below = 0;
+
+    while (!atomic_load(&pool->finished)) {
+        usleep((useconds_t)options->sample_ms * 1000);
+        reap_slots(pool);
+
+        double occupancy = (double)buffer_pending(buffer) / buffer->capacity;
+        int active = atomic_load(&pool->active);
+
+        if (occupancy >= options->high_watermark) {
+            below = 0;
+            if (++above >= options->grow_samples && active < options->max_consumers) {
+                spawn_consumer(pool);
+                above = 0;
+            }
+        } else if (occupancy <= options->low_watermark) {
+            above = 0;
+            if (++below >= options->shrink_samples && active > options->min_consumers) {
+                retire_consumer(pool);
+                below = 0;
+            }
+        } else {
+            above = 0;
+            below = 0;
+        }
+    }
+
+    // El buffer se vació: esperar a todos los consumidores
+    for (int i = 0; i < options->max_consumers; i++) {
+        PcPoolSlot *slot = &pool->slots[i];
+        if (atomic_load(&slot->state) != PC_POOL_SLOT_FREE) {
+            pthread_join(slot->thread, NULL);
+            atomic_store(&slot->state, PC_POOL_SLOT_FREE);
+        }
+    }
+    atomic_store(&pool->active, 0);
+    return NULL;
+}
+
+int pc_pool_start(PcConsumerPool *pool, ProducerConsumerBuffer *buffer,
+                  const PcPoolOptions *options) {
+    if (!pool || !buffer || !options) return -1;
+
+    if (options->min_consumers < 1 || options->max_consumers < options->min_consumers ||
+        options->max_consumers > PC_POOL_MAX_CONSUMERS ||
+        options->low_watermark >= options->high_watermark || options->sample_ms <= 0 ||
+        options->batch > PC_MAX_BATCH) {
+        fprintf(stderr, "Error: opciones del grupo de consumidores inválidas\n");
+        return -1;
+    }
+
+    pool->buffer = buffer;
+    pool->options = *options;
+    if (pool->options.batch < 1) pool->options.batch = 1;
+    if (pool->options.grow_samples < 1) pool->options.grow_samples = 1;
+    if (pool->options.shrink_samples < 1) pool->options.shrink_samples = 1;
+    atomic_init(&pool->finished, false);
+    atomic_init(&pool->active, 0);
+    atomic_init(&pool->peak, 0);
+    pool->spawned = 0;
+    pool->retired = 0;
+
+    for (int i = 0; i < PC_POOL_MAX_CONSUMERS; i++) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].id = i;
+        pool->slots[i].latency = NULL;
+        atomic_init(&pool->slots[i].state, PC_POOL_SLOT_FREE);
+        atomic_init(&pool->slots[i].retire, false);
+    }
+
+    for (int i = 0; i < pool->options.min_consumers; i++) {
+        if (spawn_consumer(pool) != 0) {
+            buffer_shutdown(buffer);
+            atomic_store(&pool->finished, true);
+            pool_controller(pool);
+            return -1;
+        }
+    }
+
+    if (pthread_create(&pool->controller, NULL, pool_controller, pool) != 0) {
+        perror("Error creando controlador del grupo");
+        buffer_shutdown(buffer);
+        atomic_store(&pool->finished, true);
+        pool_controller(pool);
+        return -1;
+    }
+
+    return 0;
+}
+
+void pc_pool_wait(PcConsumerPool *pool) {
+    if (!pool) return;
+    pthread_join(pool->controller, NULL);
+}
+
+int pc_pool_active(PcConsumerPool *pool) {
+    return pool ? atomic_load(&pool->active) : 0;
+}
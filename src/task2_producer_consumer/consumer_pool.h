@@ -0,0 +1,76 @@
+#ifndef CONSUMER_POOL_H
+#define CONSUMER_POOL_H
+
+#include "producer_consumer.h"
+
+// Grupo elástico de consumidores sobre un ProducerConsumerBuffer. Un hilo
+// controlador mide la ocupación del buffer cada sample_ms y:
+//  - agrega un consumidor si la ocupación pasó high_watermark durante
+//    grow_samples muestras seguidas (hasta max_consumers);
+//  - retira uno si estuvo por debajo de low_watermark durante
+//    shrink_samples muestras seguidas (hasta min_consumers).
+// La banda entre las dos marcas y las muestras consecutivas son la
+// histéresis: una ráfaga corta no dispara cambios y el grupo no oscila.
+// Los consumidores esperan con buffer_get_timed, así que uno ocioso nota
+// que lo retiraron en a lo sumo sample_ms.
+//
+// Al cerrar el buffer (buffer_close) los consumidores vacían lo que quede y
+// el grupo termina solo; pc_pool_wait espera ese final.
+#define PC_POOL_MAX_CONSUMERS 64
+
+typedef struct {
+    int min_consumers;          // Siempre activos (>= 1)
+    int max_consumers;          // Tope (<= PC_POOL_MAX_CONSUMERS)
+    double high_watermark;      // Ocupación (0..1) a partir de la cual crecer
+    double low_watermark;       // Ocupación por debajo de la cual achicar
+    int grow_samples;           // Muestras seguidas sobre la marca alta
+    int shrink_samples;         // Muestras seguidas bajo la marca baja
+    int sample_ms;              // Período del controlador
+    int batch;                  // Items por extracción (0 o 1 = de a uno)
+    PcConsumeFn consume;        // NULL = consume_item
+    void *ctx;
+} PcPoolOptions;
+
+// Estado de cada lugar del grupo
+typedef enum {
+    PC_POOL_SLOT_FREE,          // Sin hilo
+    PC_POOL_SLOT_RUNNING,
+    PC_POOL_SLOT_EXITED         // Terminó; falta el join
+} PcPoolSlotState;
+
+typedef struct PcConsumerPool PcConsumerPool;
+
+typedef struct {
+    PcConsumerPool *pool;
+    int id;
+    pthread_t thread;
+    atomic_int state;           // PcPoolSlotState
+    atomic_bool retire;         // Pedido del controlador
+    ConsumerLatency *latency;   // Se crea con el primer hilo del lugar y se reutiliza
+} PcPoolSlot;
+
+struct PcConsumerPool {
+    ProducerConsumerBuffer *buffer;
+    PcPoolOptions options;
+    PcPoolSlot slots[PC_POOL_MAX_CONSUMERS];
+    pthread_t controller;
+    atomic_bool finished;       // Algún consumidor vio el buffer cerrado y vacío
+    atomic_int active;          // Consumidores que no fueron retirados
+    atomic_int peak;            // Máximo de consumidores simultáneos
+    long long spawned;          // Hilos creados en total (leer tras pc_pool_wait)
+    long long retired;          // Hilos retirados por baja ocupación (ídem)
+};
+
+void pc_pool_default_options(PcPoolOptions *options);
+
+// Lanzar min_consumers consumidores y el controlador; 0 o -1
+int pc_pool_start(PcConsumerPool *pool, ProducerConsumerBuffer *buffer,
+                  const PcPoolOptions *options);
+
+// Esperar a que el buffer se cierre y se vacíe, y liberar los hilos
+void pc_pool_wait(PcConsumerPool *pool);
+
+// Consumidores activos en este momento
+int pc_pool_active(PcConsumerPool *pool);
+
+#endif // CONSUMER_POOL_H
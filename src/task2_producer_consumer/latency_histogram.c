@@ -0,0 +1,111 @@
+#define _DEFAULT_SOURCE
+#include "latency_histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+long long latency_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Índice del bucket: valores < LATENCY_SUB_BUCKETS son exactos; para el resto
+// se toma la magnitud (bit más alto) y los LATENCY_SUB_BITS bits siguientes
+static int bucket_index(unsigned long long v) {
+    if (v < LATENCY_SUB_BUCKETS) {
+        return (int)v;
+    }
+
+    int magnitude = 63 - __builtin_clzll(v);
+    int shift = magnitude - LATENCY_SUB_BITS;
+    int sub = (int)(v >> shift) - LATENCY_SUB_BUCKETS;
+    return (shift + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Mayor valor que cae en el bucket index
+static long long bucket_upper(int index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+
+    int shift = index / LATENCY_SUB_BUCKETS - 1;
+    unsigned long long sub = index % LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKETS;
+    return (long long)(((sub + 1) << shift) - 1);
+}
+
+LatencyHistogram *latency_histogram_create(void) {
+    LatencyHistogram *hist = malloc(sizeof(LatencyHistogram));
+    if (hist) {
+        latency_histogram_reset(hist);
+    }
+    return hist;
+}
+
+void latency_histogram_free(LatencyHistogram *hist) {
+    free(hist);
+}
+
+void latency_histogram_reset(LatencyHistogram *hist) {
+    memset(hist->counts, 0, sizeof(hist->counts));
+    hist->total = 0;
+    hist->sum = 0;
+    hist->min = 0;
+    hist->max = 0;
+}
+
+void latency_histogram_record(LatencyHistogram *hist, long long ns) {
+    if (ns < 0) ns = 0;
+
+    hist->counts[bucket_index((unsigned long long)ns)]++;
+    if (hist->total == 0 || ns < hist->min) hist->min = ns;
+    if (ns > hist->max) hist->max = ns;
+    hist->total++;
+    hist->sum += ns;
+}
+
+void latency_histogram_merge(LatencyHistogram *dst, const LatencyHistogram *src) {
+    if (src->total == 0) return;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    if (dst->total == 0 || src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->total += src->total;
+    dst->sum += src->sum;
+}
+
+long long latency_histogram_percentile(const LatencyHistogram *hist, double p) {
+    if (hist->total == 0) return 0;
+
+    long long rank = (long long)(p * hist->total);
+    if (rank >= hist->total) rank = hist->total - 1;
+
+    long long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen > rank) {
+            long long upper = bucket_upper(i);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void latency_histogram_print(const LatencyHistogram *hist, const char *label) {
+    if (hist->total == 0) {
+        printf("%s: sin datos\n", label);
+        return;
+    }
+
+    printf("%s (%lld items, µs): prom %.1f | p50 %.1f | p90 %.1f | p99 %.1f | p99.9 %.1f | máx %.1f\n",
+           label, hist->total,
+           hist->sum / (double)hist->total / 1000.0,
+           latency_histogram_percentile(hist, 0.50) / 1000.0,
+           latency_histogram_percentile(hist, 0.90) / 1000.0,
+           latency_histogram_percentile(hist, 0.99) / 1000.0,
+           latency_histogram_percentile(hist, 0.999) / 1000.0,
+           hist->max / 1000.0);
+}
@@ -0,0 +1,44 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdbool.h>
+
+// Histograma de latencias estilo HDR: buckets logarítmicos (uno por potencia
+// de 2) divididos en LATENCY_SUB_BUCKETS sub-buckets lineales. El error
+// relativo de cada valor registrado queda por debajo de 1/LATENCY_SUB_BUCKETS
+// (~6%) en todo el rango, de nanosegundos a minutos, con memoria fija.
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAGNITUDES (63 - LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((LATENCY_MAGNITUDES + 1) * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    long long counts[LATENCY_BUCKETS];
+    long long total;    // Número de valores registrados
+    long long sum;      // Suma de valores (para el promedio)
+    long long min;
+    long long max;
+} LatencyHistogram;
+
+// Reloj monotónico en nanosegundos
+long long latency_now_ns(void);
+
+// Crear (en el heap, ~8 KB) y liberar un histograma
+LatencyHistogram *latency_histogram_create(void);
+void latency_histogram_free(LatencyHistogram *hist);
+void latency_histogram_reset(LatencyHistogram *hist);
+
+// Registrar un valor en nanosegundos (los negativos cuentan como 0).
+// No es thread-safe: cada hilo registra en su propio histograma.
+void latency_histogram_record(LatencyHistogram *hist, long long ns);
+
+// Sumar src en dst
+void latency_histogram_merge(LatencyHistogram *dst, const LatencyHistogram *src);
+
+// Percentil p en [0, 1]; devuelve el mayor valor equivalente del bucket
+long long latency_histogram_percentile(const LatencyHistogram *hist, double p);
+
+// Imprimir conteo, promedio, p50/p90/p99/p999 y máximo
+void latency_histogram_print(const LatencyHistogram *hist, const char *label);
+
+#endif // LATENCY_HISTOGRAM_H
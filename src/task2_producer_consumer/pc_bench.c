@@ -0,0 +1,229 @@
+#define _DEFAULT_SOURCE
+#include "producer_consumer.h"
+#include "../bench/bench_harness.h"
+#include "../common/prng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+// Benchmark del buffer producer-consumer: N productores y N consumidores
+// mueven items con buffer_put/buffer_get, sin retardos simulados ni printf.
+// La latencia es el tiempo de cada llamada (incluye la espera en el semáforo).
+// Los escenarios "batch8" usan buffer_put_batch/buffer_get_batch con ráfagas
+// de 8 items; su latencia es la de cada llamada, no por item. Los "tickets"
+// usan el motor PC_ENGINE_TICKET en lugar del mutex, y los "futex" el
+// semáforo PC_SEM_FUTEX en lugar de sem_t. "rand" y "prng" sortean además
+// un retardo por item (sin dormir), como la carga simulada, con rand() de
+// la libc (estado global con lock) o con el PRNG por hilo, para ver el costo
+// del lock compartido. Al final se imprime, por caso,
+// cuántos syscalls futex y cuántos bloqueos (cambios de contexto
+// voluntarios, comparables entre los dos semáforos) costó cada item.
+
+#define PC_BENCH_ITEMS 40000   // Items por repetición, repartidos entre los productores
+#define PC_MAX_THREADS 4
+#define PC_BENCH_BATCH 8
+
+// Sorteo por item de los escenarios "rand"/"prng"
+typedef enum {
+    PC_DRAW_NONE,
+    PC_DRAW_LIBC,          // rand()
+    PC_DRAW_PRNG           // prng_thread_below()
+} PcDraw;
+
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int count;
+    int batch;     // Items por llamada (1 = de a uno)
+    PcDraw draw;
+    unsigned jitter;       // Suma de los sorteos, para que no se eliminen
+    BenchSamples samples;
+} PcWorker;
+
+typedef struct {
+    const char *name;
+    PcEngine engine;
+    PcSemKind semaphore;
+    int batch;
+    PcDraw draw;
+} PcScenario;
+
+static const PcScenario scenarios[] = {
+    {"semaphores", PC_ENGINE_MUTEX, PC_SEM_POSIX, 1, PC_DRAW_NONE},
+    {"batch8", PC_ENGINE_MUTEX, PC_SEM_POSIX, PC_BENCH_BATCH, PC_DRAW_NONE},
+    {"tickets", PC_ENGINE_TICKET, PC_SEM_POSIX, 1, PC_DRAW_NONE},
+    {"tickets-batch8", PC_ENGINE_TICKET, PC_SEM_POSIX, PC_BENCH_BATCH, PC_DRAW_NONE},
+    {"futex", PC_ENGINE_MUTEX, PC_SEM_FUTEX, 1, PC_DRAW_NONE},
+    {"futex-batch8", PC_ENGINE_MUTEX, PC_SEM_FUTEX, PC_BENCH_BATCH, PC_DRAW_NONE},
+    {"tickets-futex-b8", PC_ENGINE_TICKET, PC_SEM_FUTEX, PC_BENCH_BATCH, PC_DRAW_NONE},
+    {"rand", PC_ENGINE_TICKET, PC_SEM_FUTEX, PC_BENCH_BATCH, PC_DRAW_LIBC},
+    {"prng", PC_ENGINE_TICKET, PC_SEM_FUTEX, PC_BENCH_BATCH, PC_DRAW_PRNG},
+};
+#define PC_NUM_SCENARIOS ((int)(sizeof(scenarios) / sizeof(scenarios[0])))
+
+typedef struct {
+    ProducerConsumerBuffer buffer;
+    const PcScenario *scenario;
+    int threads;   // Productores, e igual número de consumidores
+    int items;
+    long long moved;      // Items movidos en todas las repeticiones
+    long switches;        // Cambios de contexto voluntarios en esas repeticiones
+} PcCase;
+
+static long voluntary_switches(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+}
+
+// Sortear un retardo de hasta 1 ms, como load_pause, sin dormir
+static void draw_jitter(PcWorker *w, int n) {
+    for (int i = 0; i < n; i++) {
+        if (w->draw == PC_DRAW_LIBC) {
+            w->jitter += (unsigned)(rand() % 1000);
+        } else if (w->draw == PC_DRAW_PRNG) {
+            w->jitter += prng_thread_below(1000);
+        }
+    }
+}
+
+static void *bench_producer(void *arg) {
+    PcWorker *w = (PcWorker *)arg;
+
+    int items[PC_BENCH_BATCH];
+
+    for (int i = 0; i < w->count; i += w->batch) {
+        int n = w->count - i < w->batch ? w->count - i : w->batch;
+        for (int j = 0; j < n; j++) {
+            items[j] = i + j;
+        }
+
+        long long start = bench_now_ns();
+        draw_jitter(w, n);
+        if (w->batch == 1 ? buffer_put(w->buffer, items[0])
+                          : buffer_put_batch(w->buffer, items, n)) break;
+        bench_samples_add(&w->samples, bench_now_ns() - start);
+    }
+
+    return NULL;
+}
+
+static void *bench_consumer(void *arg) {
+    PcWorker *w = (PcWorker *)arg;
+    int items[PC_BENCH_BATCH];
+
+    for (int i = 0; i < w->count; ) {
+        int max = w->count - i < w->batch ? w->count - i : w->batch;
+
+        long long start = bench_now_ns();
+        int taken = buffer_get_batch(w->buffer, items, NULL, max);
+        if (taken <= 0) break;
+        draw_jitter(w, taken);
+        bench_samples_add(&w->samples, bench_now_ns() - start);
+        i += taken;
+    }
+
+    return NULL;
+}
+
+// Una repetición: cada consumidor extrae exactamente lo que produce un productor
+static int pc_run(void *ctx, BenchRun *run) {
+    PcCase *pc = (PcCase *)ctx;
+    PcWorker workers[2 * PC_MAX_THREADS];
+    pthread_t threads[2 * PC_MAX_THREADS];
+    int per_thread = pc->items / pc->threads;
+
+    long switches = voluntary_switches();
+    long long start = bench_now_ns();
+    for (int i = 0; i < 2 * pc->threads; i++) {
+        workers[i].buffer = &pc->buffer;
+        workers[i].count = per_thread;
+        workers[i].batch = pc->scenario->batch;
+        workers[i].draw = pc->scenario->draw;
+        workers[i].jitter = 0;
+        bench_samples_init(&workers[i].samples);
+        pthread_create(&threads[i], NULL, i < pc->threads ? bench_consumer : bench_producer,
+                       &workers[i]);
+    }
+    for (int i = 0; i < 2 * pc->threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    run->seconds = (bench_now_ns() - start) / 1e9;
+    run->ops = (long long)per_thread * pc->threads;
+    pc->switches += voluntary_switches() - switches;
+    pc->moved += run->ops;
+
+    for (int i = 0; i < 2 * pc->threads; i++) {
+        bench_samples_append(run->samples, &workers[i].samples);
+        bench_samples_free(&workers[i].samples);
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config;
+    if (bench_parse_args(&config, argc, argv) != 0) {
+        return 1;
+    }
+
+    printf("Benchmark Producer-Consumer\n");
+    printf("===========================\n");
+
+    static const int thread_counts[] = {1, 2, 4};
+    static const int capacities[] = {1, 16, 256, 4096};
+    int num_threads = config.quick ? 2 : 3;
+    int num_capacities = config.quick ? 2 : 4;
+    int per_scenario = num_threads * num_capacities;
+    int num_cases = PC_NUM_SCENARIOS * per_scenario;
+    PcCase cases[PC_NUM_SCENARIOS * 12];
+
+    // Inicializar los buffers antes de imprimir la tabla de resultados
+    for (int i = 0; i < num_cases; i++) {
+        int k = i % per_scenario;
+        cases[i].scenario = &scenarios[i / per_scenario];
+        cases[i].threads = thread_counts[k / num_capacities];
+        cases[i].items = config.quick ? PC_BENCH_ITEMS / 10 : PC_BENCH_ITEMS;
+        cases[i].moved = 0;
+        cases[i].switches = 0;
+
+        PcBufferOptions options;
+        pc_buffer_default_options(&options);
+        options.capacity = capacities[k % num_capacities];
+        options.engine = cases[i].scenario->engine;
+        options.semaphore = cases[i].scenario->semaphore;
+        options.quiet = true;
+        if (init_buffer_ex(&cases[i].buffer, &options) != 0) {
+            return 1;
+        }
+    }
+
+    BenchReport report;
+    bench_report_init(&report, "pc", &config);
+
+    int result = 0;
+    for (int i = 0; i < num_cases && result == 0; i++) {
+        BenchCase bc = {cases[i].scenario->name, 2 * cases[i].threads,
+                        cases[i].buffer.capacity, (int)sizeof(int)};
+        result = bench_run(&report, &bc, pc_run, &cases[i]);
+    }
+
+    if (bench_report_finish(&report) != 0) {
+        result = -1;
+    }
+
+    // Costo de bloqueo por item; sem_t no expone sus syscalls, los bloqueos sí
+    printf("\n%-16s %7s %8s %12s %12s\n", "scenario", "threads", "capacity", "futex/op", "blocks/op");
+    for (int i = 0; i < num_cases; i++) {
+        PcCase *pc = &cases[i];
+        if (pc->moved == 0) continue;
+        long long syscalls = pc_sem_syscalls(&pc->buffer.empty) + pc_sem_syscalls(&pc->buffer.full);
+        printf("%-16s %7d %8d %12.3f %12.3f\n", pc->scenario->name, 2 * pc->threads,
+               pc->buffer.capacity, (double)syscalls / pc->moved, (double)pc->switches / pc->moved);
+    }
+
+    for (int i = 0; i < num_cases; i++) {
+        destroy_buffer(&cases[i].buffer);
+    }
+
+    return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+#define _DEFAULT_SOURCE
+#include "pc_semaphore.h"
+#include <errno.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// timeout relativo, o NULL para esperar sin límite
+static void futex_wait(PcSemaphore *sem, int expected, const struct timespec *timeout) {
+    atomic_fetch_add_explicit(&sem->syscalls, 1, memory_order_relaxed);
+    // EAGAIN (el valor ya cambió), EINTR o ETIMEDOUT: el llamador vuelve a
+    // mirar el contador y el reloj
+    syscall(SYS_futex, &sem->count, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+static void futex_wake(PcSemaphore *sem, int n) {
+    atomic_fetch_add_explicit(&sem->syscalls, 1, memory_order_relaxed);
+    syscall(SYS_futex, &sem->count, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+#endif
+
+static long long clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static struct timespec to_timespec(long long ns) {
+    struct timespec ts = {(time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL)};
+    return ts;
+}
+
+int pc_sem_init(PcSemaphore *sem, PcSemKind kind, int value, int spin) {
+    if (!sem || value < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    sem->kind = kind;
+    sem->spin = spin > 0 ? spin : 0;
+    atomic_init(&sem->count, value);
+    atomic_init(&sem->waiters, 0);
+    atomic_init(&sem->syscalls, 0);
+
+    if (kind == PC_SEM_POSIX) {
+        return sem_init(&sem->posix, 0, (unsigned)value);
+    }
+
+#ifdef __linux__
+    if (kind == PC_SEM_FUTEX) {
+        return 0;
+    }
+#endif
+
+    errno = EINVAL;
+    return -1;
+}
+
+void pc_sem_destroy(PcSemaphore *sem) {
+    if (sem && sem->kind == PC_SEM_POSIX) {
+        sem_destroy(&sem->posix);
+    }
+}
+
+// Tomar un permiso si el contador es positivo
+static int try_take(PcSemaphore *sem, int max) {
+    int count = atomic_load_explicit(&sem->count, memory_order_relaxed);
+    while (count > 0) {
+        int take = count < max ? count : max;
+        if (atomic_compare_exchange_weak_explicit(&sem->count, &count, count - take,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return take;
+        }
+    }
+    return 0;
+}
+
+// Espera común: deadline_ns < 0 = sin límite
+static int sem_wait_until(PcSemaphore *sem, long long deadline_ns) {
+    if (sem->kind == PC_SEM_POSIX) {
+        if (deadline_ns < 0) {
+            return sem_wait(&sem->posix);
+        }
+        // sem_timedwait usa CLOCK_REALTIME: trasladar el plazo monotónico
+        long long remaining = deadline_ns - clock_ns(CLOCK_MONOTONIC);
+        struct timespec abstime = to_timespec(clock_ns(CLOCK_REALTIME) +
+                                              (remaining > 0 ? remaining : 0));
+        return sem_timedwait(&sem->posix, &abstime);
+    }
+
+#ifdef __linux__
+    // Camino rápido, y giro opcional antes de dormir
+    for (int i = 0; i <= sem->spin; i++) {
+        if (try_take(sem, 1)) return 0;
+    }
+
+    // Anunciarse una sola vez, antes de volver a mirar: un post que suma
+    // después de esta lectura ve waiters > 0 y despierta (ambos seq_cst).
+    // El hilo sigue contado hasta tomar su permiso, también despierto entre
+    // un futex_wait y el siguiente intento: así post_n sabe que cada permiso
+    // que ya había tiene un hilo contado en camino a tomarlo.
+    atomic_fetch_add(&sem->waiters, 1);
+    for (;;) {
+        if (try_take(sem, 1)) {
+            atomic_fetch_sub(&sem->waiters, 1);
+            return 0;
+        }
+
+        struct timespec timeout;
+        if (deadline_ns >= 0) {
+            long long remaining = deadline_ns - clock_ns(CLOCK_MONOTONIC);
+            if (remaining <= 0) {
+                // Un post pudo contar con este hilo después del último
+                // intento: si quedó un permiso y alguien duerme, pasárselo
+                int waiters = atomic_fetch_sub(&sem->waiters, 1) - 1;
+                if (waiters > 0 && atomic_load(&sem->count) > 0) {
+                    futex_wake(sem, 1);
+                }
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            timeout = to_timespec(remaining);
+        }
+
+        if (atomic_load(&sem->count) == 0) {
+            futex_wait(sem, 0, deadline_ns >= 0 ? &timeout : NULL);
+        }
+    }
+#else
+    (void)deadline_ns;
+    errno = EINVAL;
+    return -1;
+#endif
+}
+
+int pc_sem_wait(PcSemaphore *sem) {
+    return sem_wait_until(sem, -1);
+}
+
+int pc_sem_timedwait(PcSemaphore *sem, long long deadline_ns) {
+    return sem_wait_until(sem, deadline_ns < 0 ? 0 : deadline_ns);
+}
+
+int pc_sem_try_wait_n(PcSemaphore *sem, int max) {
+    if (max <= 0) return 0;
+
+    if (sem->kind == PC_SEM_POSIX) {
+        int taken = 0;
+        while (taken < max && sem_trywait(&sem->posix) == 0) {
+            taken++;
+        }
+        return taken;
+    }
+
+    return try_take(sem, max);
+}
+
+void pc_sem_post_n(PcSemaphore *sem, int n) {
+    if (n <= 0) return;
+
+    if (sem->kind == PC_SEM_POSIX) {
+        for (int i = 0; i < n; i++) {
+            sem_post(&sem->posix);
+        }
+        return;
+    }
+
+#ifdef __linux__
+    int before = atomic_fetch_add(&sem->count, n);
+
+    // Sin nadie esperando no hace falta entrar al kernel. Un hilo deja de
+    // contar en waiters recién al tomar su permiso, así que por cada permiso
+    // que ya había hay un hilo contado despierto (o por despertarse) que lo
+    // va a tomar: sólo se despierta a los que esperan de más. Si el
+    // despertado no encuentra permiso (se lo ganó un try_wait) vuelve a
+    // dormir sin dejar de contar, y el próximo post lo cuenta de nuevo.
+    int waiters = atomic_load(&sem->waiters);
+    if (waiters > before) {
+        futex_wake(sem, waiters - before < n ? waiters - before : n);
+    }
+#endif
+}
+
+long long pc_sem_syscalls(PcSemaphore *sem) {
+    return atomic_load_explicit(&sem->syscalls, memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+#ifndef PC_SEMAPHORE_H
+#define PC_SEMAPHORE_H
+
+#include <semaphore.h>
+#include <stdatomic.h>
+
+// Semáforo contador del buffer, con dos implementaciones intercambiables:
+//  - PC_SEM_POSIX: sem_t de POSIX, como hasta ahora.
+//  - PC_SEM_FUTEX: contador atómico; sólo se entra al kernel (futex) cuando
+//    un hilo tiene que dormir porque el contador está en 0, o cuando un post
+//    encuentra hilos dormidos. Opcionalmente gira unas vueltas antes de
+//    dormir, por si el permiso llega enseguida.
+// Las dos permiten tomar y devolver varios permisos de una vez; con futex
+// eso cuesta una sola operación atómica y como mucho un syscall.
+
+typedef enum {
+    PC_SEM_POSIX,
+    PC_SEM_FUTEX               // Sólo Linux
+} PcSemKind;
+
+typedef struct {
+    PcSemKind kind;
+    sem_t posix;
+    _Atomic int count;         // Permisos disponibles (futex)
+    _Atomic int waiters;       // Hilos en el camino lento hasta tomar su permiso (futex)
+    int spin;                  // Vueltas antes de dormir (futex)
+    atomic_llong syscalls;     // Llamadas a futex realizadas (espera + despertar)
+} PcSemaphore;
+
+// Inicializar con value permisos; devuelve 0 o -1 (tipo no soportado)
+int pc_sem_init(PcSemaphore *sem, PcSemKind kind, int value, int spin);
+void pc_sem_destroy(PcSemaphore *sem);
+
+// Tomar un permiso esperando si hace falta; 0 o -1 con errno (EINTR sólo
+// en POSIX, el futex reintenta solo)
+int pc_sem_wait(PcSemaphore *sem);
+
+// Como pc_sem_wait pero con un límite: deadline_ns es un instante de
+// CLOCK_MONOTONIC en ns (el reloj de latency_now_ns). Devuelve 0, o -1 con
+// errno = ETIMEDOUT si venció sin permiso (EINTR sólo en POSIX)
+int pc_sem_timedwait(PcSemaphore *sem, long long deadline_ns);
+
+// Tomar hasta max permisos sin bloquear; devuelve cuántos tomó (0 si no hay)
+int pc_sem_try_wait_n(PcSemaphore *sem, int max);
+
+// Devolver n permisos (despierta a lo sumo n hilos)
+void pc_sem_post_n(PcSemaphore *sem, int n);
+
+static inline void pc_sem_post(PcSemaphore *sem) {
+    pc_sem_post_n(sem, 1);
+}
+
+// Syscalls futex hechas hasta ahora (0 para POSIX, que no se puede observar)
+long long pc_sem_syscalls(PcSemaphore *sem);
+
+#endif // PC_SEMAPHORE_H
@@ -1,13 +1,54 @@
+#define _DEFAULT_SOURCE
 #include "producer_consumer.h"
+#include "pipeline.h"
+#include "consumer_pool.h"
+#include "../common/prng.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <time.h>
 #include <signal.h>
+#include <sched.h>
+#include <sys/resource.h>
 
 #define NUM_PRODUCERS 3
 #define NUM_CONSUMERS 2
 #define ITEMS_PER_PRODUCER 10
+#define SWEEP_THREADS 2          // Productores y consumidores en el barrido de capacidad
+#define SWEEP_ITEMS 20000        // Items por capacidad
+#define SWEEP_MAX_CAPACITY 1024
+#define BATCH_TEST_THREADS 2
+#define BATCH_TEST_ITEMS 20000   // Por productor
+#define BATCH_TEST_SIZE 8
+#define SEM_STRESS_WAITERS 6
+#define SEM_STRESS_ROUNDS 5000
+#define SEM_STRESS_MAX_MS 1000   // Por ronda; sin despertares perdidos basta con mucho menos
+#define CLOSE_TEST_PRODUCERS 2
+#define CLOSE_TEST_CONSUMERS 4
+#define CLOSE_TEST_ITEMS 5000     // Por productor
+#define CLOSE_MAX_EXIT_MS 100     // Cota holgada para que salgan todos tras cerrar
+#define CALLBACK_TEST_PRODUCERS 2
+#define CALLBACK_TEST_CONSUMERS 3
+#define CALLBACK_TEST_ITEMS 10000   // Total, repartido por el contexto compartido
+#define CALLBACK_MAX_MS 2000        // Sin carga simulada debe tardar mucho menos
+#define PIPELINE_TEST_ITEMS 2000    // Generados por la fuente
+#define PIPELINE_SLOW_US 200        // Trabajo por item de la etapa lenta
+#define POOL_TEST_BURST 1500       // Items de la ráfaga
+#define POOL_TEST_WORK_US 400       // Trabajo por item: un consumidor no da abasto
+#define POOL_TEST_IDLE_MS 400       // Pausa tras la ráfaga para que el grupo se achique
+#define PRNG_TEST_DRAWS 1000
+#define OVERFLOW_TEST_CAPACITY 4
+#define OVERFLOW_TEST_PUTS 10
+#define OVERFLOW_STRESS_ITEMS 20000   // Por productor, con pisado concurrente
+#define RATE_TEST_LIMIT 2000.0        // Items/s
+#define RATE_TEST_BURST 10
+#define RATE_TEST_ITEMS 110
+#define RATE_CLOSE_TEST_LIMIT 1.0     // Items/s: el segundo put espera ~1 s
+#define RATE_CLOSE_TEST_MS 20         // Cierre durante esa espera
+#define RATE_CLOSE_TEST_MAX_MS 50     // Tiempo máximo para salir tras el cierre
+#define TRACE_TEST_THREADS 2
+#define TRACE_TEST_EVENTS (3 * TRACE_RING_SIZE)   // Por hilo: fuerza anillos llenos
 
 // Variables globales para manejo de señales
 static ProducerConsumerBuffer *global_buffer = NULL;
@@ -20,7 +61,7 @@ static ThreadData consumer_data[NUM_CONSUMERS];
 void signal_handler(int sig) {
     printf("\n\nRecibida señal %d. Terminando programa...\n", sig);
     if (global_buffer) {
-        global_buffer->shutdown = true;
+        buffer_shutdown(global_buffer);
     }
 }
 
@@ -29,14 +70,14 @@ int test_basic_functionality() {
     printf("\n=== Probando Funcionalidad Básica ===\n");
     
     ProducerConsumerBuffer buffer;
-    if (init_buffer(&buffer) != 0) {
+    if (init_buffer(&buffer, BUFFER_SIZE) != 0) {
         printf("❌ Error inicializando buffer\n");
         return -1;
     }
     
     // Test simple: un productor, un consumidor
-    ThreadData prod_data = {&buffer, 0, 3};
-    ThreadData cons_data = {&buffer, 0, 0};
+    ThreadData prod_data = {&buffer, 0, 3, 1, NULL, NULL, NULL, NULL};
+    ThreadData cons_data = {&buffer, 0, 0, 1, NULL, NULL, NULL, NULL};
     
     pthread_t prod_thread, cons_thread;
     
@@ -49,21 +90,16 @@ int test_basic_functionality() {
     
     if (pthread_create(&prod_thread, NULL, producer, &prod_data) != 0) {
         perror("Error creando productor");
-        buffer.shutdown = true;
+        buffer_close(&buffer);
         pthread_join(cons_thread, NULL);
         destroy_buffer(&buffer);
         return -1;
     }
     
-    // Esperar a que termine el productor
+    // Esperar a que termine el productor y cerrar: el consumidor vacía el
+    // buffer y sale solo
     pthread_join(prod_thread, NULL);
-    
-    // Dar tiempo para que el consumidor procese
-    sleep(1);
-    
-    // Terminar consumidor
-    buffer.shutdown = true;
-    sem_post(&buffer.full); // Despertar al consumidor
+    buffer_close(&buffer);
     pthread_join(cons_thread, NULL);
     
     print_statistics(&buffer);
@@ -75,12 +111,1349 @@ int test_basic_functionality() {
     return success ? 0 : -1;
 }
 
+// Test del histograma de latencias (precisión de percentiles y combinación)
+int test_latency_histogram() {
+    printf("\n=== Probando Histograma de Latencias ===\n");
+    
+    LatencyHistogram *a = latency_histogram_create();
+    LatencyHistogram *b = latency_histogram_create();
+    if (!a || !b) {
+        printf("❌ Error creando histogramas\n");
+        latency_histogram_free(a);
+        latency_histogram_free(b);
+        return -1;
+    }
+    
+    // 1..100000 µs repartidos entre dos histogramas (como dos consumidores)
+    for (long long us = 1; us <= 100000; us++) {
+        latency_histogram_record(us % 2 ? a : b, us * 1000);
+    }
+    latency_histogram_merge(a, b);
+    
+    bool success = (a->total == 100000 && a->min == 1000 && a->max == 100000000LL);
+    
+    // Cada percentil debe quedar dentro del error relativo de un sub-bucket
+    double percentiles[] = {0.50, 0.90, 0.99, 0.999};
+    for (int i = 0; i < 4; i++) {
+        double expected = percentiles[i] * 100000 * 1000.0;
+        double got = latency_histogram_percentile(a, percentiles[i]);
+        double error = (got - expected) / expected;
+        if (error < -0.01 || error > 1.0 / LATENCY_SUB_BUCKETS) {
+            printf("❌ p%.1f = %.0f ns, esperado ~%.0f ns\n", percentiles[i] * 100, got, expected);
+            success = false;
+        }
+    }
+    
+    latency_histogram_print(a, "Histograma combinado");
+    printf("Histograma de latencias: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    
+    latency_histogram_free(a);
+    latency_histogram_free(b);
+    return success ? 0 : -1;
+}
+
+// Datos de los hilos de la prueba por lotes
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int thread_id;
+    int batch;          // 1 = buffer_put/buffer_get, >1 = variantes por lotes
+    int *seen;          // Sólo consumidores: veces que apareció cada item
+    long long batches;  // Sólo consumidores: llamadas a buffer_get_batch
+} BatchData;
+
+void *batch_producer(void *arg) {
+    BatchData *data = (BatchData *)arg;
+    int items[BATCH_TEST_SIZE];
+    
+    for (int i = 0; i < BATCH_TEST_ITEMS; i += data->batch) {
+        for (int j = 0; j < data->batch; j++) {
+            items[j] = data->thread_id * BATCH_TEST_ITEMS + i + j;
+        }
+        if (data->batch == 1 ? buffer_put(data->buffer, items[0])
+                             : buffer_put_batch(data->buffer, items, data->batch)) break;
+    }
+    return NULL;
+}
+
+void *batch_consumer(void *arg) {
+    BatchData *data = (BatchData *)arg;
+    int items[BATCH_TEST_SIZE];
+    
+    // Cada consumidor extrae exactamente lo que inserta un productor
+    for (int remaining = BATCH_TEST_ITEMS; remaining > 0; ) {
+        int max = remaining < data->batch ? remaining : data->batch;
+        int taken = buffer_get_batch(data->buffer, items, NULL, max);
+        if (taken <= 0) break;
+        for (int j = 0; j < taken; j++) {
+            data->seen[items[j]]++;   // Índices distintos salvo que haya duplicados
+        }
+        data->batches++;
+        remaining -= taken;
+    }
+    return NULL;
+}
+
+static PcBufferOptions make_options(PcEngine engine, PcSemKind semaphore, int capacity) {
+    PcBufferOptions options;
+    pc_buffer_default_options(&options);
+    options.capacity = capacity;
+    options.engine = engine;
+    options.semaphore = semaphore;
+    return options;
+}
+
+// Mover todos los items con lotes de tamaño batch; devuelve items/s o -1.
+// syscalls (puede ser NULL) recibe los futex hechos por los dos semáforos.
+static double run_batch_case(PcBufferOptions options, int batch, int *seen,
+                             long long *batches, long long *syscalls) {
+    ProducerConsumerBuffer buffer;
+    if (init_buffer_ex(&buffer, &options) != 0) return -1;
+    
+    pthread_t threads[2 * BATCH_TEST_THREADS];
+    BatchData data[2 * BATCH_TEST_THREADS];
+    
+    long long start = latency_now_ns();
+    for (int i = 0; i < 2 * BATCH_TEST_THREADS; i++) {
+        data[i] = (BatchData){&buffer, i % BATCH_TEST_THREADS, batch, seen, 0};
+        pthread_create(&threads[i], NULL, i < BATCH_TEST_THREADS ? batch_consumer : batch_producer,
+                       &data[i]);
+    }
+    for (int i = 0; i < 2 * BATCH_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = (latency_now_ns() - start) / 1e9;
+    
+    *batches = 0;
+    for (int i = 0; i < BATCH_TEST_THREADS; i++) {
+        *batches += data[i].batches;
+    }
+    
+    if (syscalls) {
+        *syscalls = pc_sem_syscalls(&buffer.empty) + pc_sem_syscalls(&buffer.full);
+    }
+    
+    bool drained = is_buffer_empty(&buffer);
+    destroy_buffer(&buffer);
+    return drained ? BATCH_TEST_THREADS * BATCH_TEST_ITEMS / seconds : -1;
+}
+
+// Test de las variantes por lotes: cada item se entrega exactamente una vez,
+// y producer()/consumer() funcionan con ráfagas
+int test_batch_operations() {
+    printf("\n=== Probando Operaciones por Lotes ===\n");
+    
+    int total = BATCH_TEST_THREADS * BATCH_TEST_ITEMS;
+    int *seen = calloc(total, sizeof(int));
+    if (!seen) {
+        printf("❌ Error reservando memoria\n");
+        return -1;
+    }
+    
+    bool success = true;
+    int sizes[] = {1, BATCH_TEST_SIZE};
+    for (int s = 0; s < 2; s++) {
+        memset(seen, 0, total * sizeof(int));
+        long long batches;
+        double throughput = run_batch_case(
+            make_options(PC_ENGINE_MUTEX, PC_SEM_POSIX, 2 * BATCH_TEST_SIZE),
+            sizes[s], seen, &batches, NULL);
+        
+        int wrong = 0;
+        for (int i = 0; i < total; i++) {
+            if (seen[i] != 1) wrong++;
+        }
+        
+        printf("Lote %d: %.0f items/s, %.2f items por extracción\n",
+               sizes[s], throughput, batches ? (double)total / batches : 0.0);
+        if (throughput < 0 || wrong != 0) {
+            printf("❌ Lote %d: %d items perdidos o duplicados\n", sizes[s], wrong);
+            success = false;
+        }
+    }
+    free(seen);
+    
+    // producer()/consumer() con ráfagas de 4 items
+    ProducerConsumerBuffer buffer;
+    if (init_buffer(&buffer, BUFFER_SIZE) != 0) {
+        printf("❌ Error inicializando buffer\n");
+        return -1;
+    }
+    
+    ThreadData prod_data = {&buffer, 0, 8, 4, NULL, NULL, NULL, NULL};
+    ThreadData cons_data = {&buffer, 0, 0, 4, NULL, NULL, NULL, NULL};
+    pthread_t prod_thread, cons_thread;
+    pthread_create(&cons_thread, NULL, consumer, &cons_data);
+    pthread_create(&prod_thread, NULL, producer, &prod_data);
+    pthread_join(prod_thread, NULL);
+    buffer_close(&buffer);
+    pthread_join(cons_thread, NULL);
+    
+    if (buffer.items_produced != 8 || buffer.items_consumed != 8) {
+        printf("❌ Ráfagas: producidos %d, consumidos %d (esperados 8)\n",
+               buffer.items_produced, buffer.items_consumed);
+        success = false;
+    }
+    destroy_buffer(&buffer);
+    
+    printf("Operaciones por lotes: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Test del motor de tickets: entrega exacta con y sin lotes, incluida una
+// capacidad que no es potencia de 2 (menos items en vuelo que posiciones)
+int test_ticket_engine() {
+    printf("\n=== Probando Motor de Tickets ===\n");
+    
+    int total = BATCH_TEST_THREADS * BATCH_TEST_ITEMS;
+    int *seen = calloc(total, sizeof(int));
+    if (!seen) {
+        printf("❌ Error reservando memoria\n");
+        return -1;
+    }
+    
+    bool success = true;
+    int capacities[] = {1, 10, 2 * BATCH_TEST_SIZE};
+    int sizes[] = {1, BATCH_TEST_SIZE};
+    for (int c = 0; c < 3; c++) {
+        for (int s = 0; s < 2; s++) {
+            memset(seen, 0, total * sizeof(int));
+            long long batches;
+            double mutex_rate = run_batch_case(
+                make_options(PC_ENGINE_MUTEX, PC_SEM_POSIX, capacities[c]),
+                sizes[s], seen, &batches, NULL);
+            memset(seen, 0, total * sizeof(int));
+            double ticket_rate = run_batch_case(
+                make_options(PC_ENGINE_TICKET, PC_SEM_POSIX, capacities[c]),
+                sizes[s], seen, &batches, NULL);
+            
+            int wrong = 0;
+            for (int i = 0; i < total; i++) {
+                if (seen[i] != 1) wrong++;
+            }
+            
+            printf("Capacidad %2d, lote %d: mutex %.0f items/s, tickets %.0f items/s\n",
+                   capacities[c], sizes[s], mutex_rate, ticket_rate);
+            if (ticket_rate < 0 || wrong != 0) {
+                printf("❌ %d items perdidos o duplicados con tickets\n", wrong);
+                success = false;
+            }
+        }
+    }
+    free(seen);
+    
+    printf("Motor de tickets: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Despierta a un hilo bloqueado en el semáforo después de una pausa
+void *delayed_post(void *arg) {
+    usleep(50000);
+    pc_sem_post((PcSemaphore *)arg);
+    return NULL;
+}
+
+// Datos de la prueba de estrés del futex con varios hilos esperando
+typedef struct {
+    PcSemaphore *sem;
+    atomic_int *taken;          // Permisos tomados entre todos
+    atomic_bool *stop;
+} SemStressData;
+
+void *sem_stress_waiter(void *arg) {
+    SemStressData *data = (SemStressData *)arg;
+    for (;;) {
+        pc_sem_wait(data->sem);
+        if (atomic_load(data->stop)) break;
+        atomic_fetch_add(data->taken, 1);
+    }
+    return NULL;
+}
+
+// Cambios de contexto voluntarios del proceso (bloqueos en el kernel)
+static long voluntary_switches() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+}
+
+// Test del semáforo futex: semántica básica, que el camino sin contención no
+// haga syscalls, y entrega exacta en el buffer comparado con sem_t
+int test_futex_semaphore() {
+    printf("\n=== Probando Semáforo Futex ===\n");
+    
+    bool success = true;
+    PcSemaphore sem;
+    if (pc_sem_init(&sem, PC_SEM_FUTEX, 0, 0) != 0) {
+        printf("❌ Error inicializando semáforo futex\n");
+        return -1;
+    }
+    
+    // Sin contención: ni post ni try_wait entran al kernel
+    bool basic = pc_sem_try_wait_n(&sem, 4) == 0;
+    pc_sem_post_n(&sem, 3);
+    basic = basic && pc_sem_try_wait_n(&sem, 5) == 3;
+    pc_sem_post(&sem);
+    basic = basic && pc_sem_wait(&sem) == 0 && pc_sem_syscalls(&sem) == 0;
+    
+    // Con el contador en 0 el hilo duerme hasta el post
+    pthread_t poster;
+    pthread_create(&poster, NULL, delayed_post, &sem);
+    basic = basic && pc_sem_wait(&sem) == 0;
+    pthread_join(poster, NULL);
+    basic = basic && pc_sem_syscalls(&sem) >= 1 && pc_sem_try_wait_n(&sem, 1) == 0;
+    pc_sem_destroy(&sem);
+    
+    if (!basic) {
+        printf("❌ Semántica básica del semáforo futex incorrecta\n");
+        success = false;
+    }
+    
+    // Varios hilos esperando y posts de a uno, por rondas: cada ronda
+    // reparte un permiso por hilo y espera a que se tomen todos. Un
+    // despertar perdido deja a alguno dormido con permisos disponibles y la
+    // ronda no se completa
+    PcSemaphore stress;
+    pc_sem_init(&stress, PC_SEM_FUTEX, 0, 0);
+    atomic_int taken = 0;
+    atomic_bool stop = false;
+    SemStressData stress_data = {&stress, &taken, &stop};
+    pthread_t waiters[SEM_STRESS_WAITERS];
+    for (int i = 0; i < SEM_STRESS_WAITERS; i++) {
+        pthread_create(&waiters[i], NULL, sem_stress_waiter, &stress_data);
+    }
+    
+    int stuck_round = -1;
+    for (int round = 0; round < SEM_STRESS_ROUNDS && stuck_round < 0; round++) {
+        for (int i = 0; i < SEM_STRESS_WAITERS; i++) {
+            pc_sem_post(&stress);
+        }
+        long long round_start = latency_now_ns();
+        while (atomic_load(&taken) < (round + 1) * SEM_STRESS_WAITERS) {
+            if (latency_now_ns() - round_start > SEM_STRESS_MAX_MS * 1000000LL) {
+                stuck_round = round;
+                break;
+            }
+            sched_yield();
+        }
+    }
+    int left = atomic_load(&stress.count);
+    
+    // Un permiso más por hilo para que todos vean stop y salgan
+    atomic_store(&stop, true);
+    pc_sem_post_n(&stress, SEM_STRESS_WAITERS);
+    for (int i = 0; i < SEM_STRESS_WAITERS; i++) {
+        pthread_join(waiters[i], NULL);
+    }
+    
+    if (stuck_round >= 0) {
+        printf("❌ Futex con %d hilos esperando: ronda %d colgada con %d permisos sin tomar\n",
+               SEM_STRESS_WAITERS, stuck_round, left);
+        success = false;
+    } else if (atomic_load(&stress.waiters) != 0) {
+        printf("❌ Futex: quedaron %d hilos contados como esperando\n", atomic_load(&stress.waiters));
+        success = false;
+    } else {
+        printf("✅ %d hilos esperando, %d rondas de posts de a uno: sin despertares perdidos\n",
+               SEM_STRESS_WAITERS, SEM_STRESS_ROUNDS);
+    }
+    pc_sem_destroy(&stress);
+    
+    int total = BATCH_TEST_THREADS * BATCH_TEST_ITEMS;
+    int *seen = calloc(total, sizeof(int));
+    if (!seen) {
+        printf("❌ Error reservando memoria\n");
+        return -1;
+    }
+    
+    // Mismo tráfico con cada semáforo: throughput, syscalls futex por item y
+    // bloqueos (cambios de contexto voluntarios) por item
+    PcSemKind kinds[] = {PC_SEM_POSIX, PC_SEM_FUTEX};
+    const char *names[] = {"sem_t", "futex"};
+    int sizes[] = {1, BATCH_TEST_SIZE};
+    printf("%-6s %5s %14s %14s %14s\n", "semáf.", "lote", "items/s", "futex/item", "bloqueos/item");
+    for (int s = 0; s < 2; s++) {
+        for (int k = 0; k < 2; k++) {
+            memset(seen, 0, total * sizeof(int));
+            long long batches, syscalls;
+            long switches = voluntary_switches();
+            double rate = run_batch_case(make_options(PC_ENGINE_MUTEX, kinds[k], 2 * BATCH_TEST_SIZE),
+                                         sizes[s], seen, &batches, &syscalls);
+            switches = voluntary_switches() - switches;
+            
+            int wrong = 0;
+            for (int i = 0; i < total; i++) {
+                if (seen[i] != 1) wrong++;
+            }
+            
+            printf("%-6s %5d %14.0f %14.3f %14.3f\n", names[k], sizes[s], rate,
+                   (double)syscalls / total, (double)switches / total);
+            if (rate < 0 || wrong != 0) {
+                printf("❌ %s: %d items perdidos o duplicados\n", names[k], wrong);
+                success = false;
+            }
+        }
+    }
+    free(seen);
+    
+    printf("Semáforo futex: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Datos de los hilos de la prueba de cierre
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int items;          // Productores: items a insertar (-1 = hasta que se cierre)
+    int done;           // Items insertados/extraídos
+} CloseData;
+
+void *close_producer(void *arg) {
+    CloseData *data = (CloseData *)arg;
+    for (int i = 0; data->items < 0 || i < data->items; i++) {
+        if (buffer_put(data->buffer, i) != 0) break;
+        data->done++;
+    }
+    return NULL;
+}
+
+void *close_consumer(void *arg) {
+    CloseData *data = (CloseData *)arg;
+    int item;
+    while (buffer_get(data->buffer, &item) == 0) {
+        data->done++;
+    }
+    return NULL;
+}
+
+// Cerrar un buffer con productores y consumidores en marcha y verificar que
+// no se pierde nada y que todos salen enseguida. Si close_early, se cierra
+// mientras los productores siguen insertando.
+static bool run_close_case(PcEngine engine, PcSemKind semaphore, bool close_early) {
+    ProducerConsumerBuffer buffer;
+    PcBufferOptions options = make_options(engine, semaphore, 4);
+    if (init_buffer_ex(&buffer, &options) != 0) return false;
+    
+    pthread_t producers[CLOSE_TEST_PRODUCERS], consumers[CLOSE_TEST_CONSUMERS];
+    CloseData prod_data[CLOSE_TEST_PRODUCERS], cons_data[CLOSE_TEST_CONSUMERS];
+    
+    for (int i = 0; i < CLOSE_TEST_CONSUMERS; i++) {
+        cons_data[i] = (CloseData){&buffer, 0, 0};
+        pthread_create(&consumers[i], NULL, close_consumer, &cons_data[i]);
+    }
+    for (int i = 0; i < CLOSE_TEST_PRODUCERS; i++) {
+        prod_data[i] = (CloseData){&buffer, close_early ? -1 : CLOSE_TEST_ITEMS, 0};
+        pthread_create(&producers[i], NULL, close_producer, &prod_data[i]);
+    }
+    
+    long long close_ns;
+    if (close_early) {
+        usleep(20000);
+        close_ns = latency_now_ns();
+        buffer_close(&buffer);
+        for (int i = 0; i < CLOSE_TEST_PRODUCERS; i++) {
+            pthread_join(producers[i], NULL);
+        }
+    } else {
+        for (int i = 0; i < CLOSE_TEST_PRODUCERS; i++) {
+            pthread_join(producers[i], NULL);
+        }
+        close_ns = latency_now_ns();
+        buffer_close(&buffer);
+    }
+    for (int i = 0; i < CLOSE_TEST_CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    double exit_ms = (latency_now_ns() - close_ns) / 1e6;
+    
+    int produced = 0, consumed = 0;
+    for (int i = 0; i < CLOSE_TEST_PRODUCERS; i++) produced += prod_data[i].done;
+    for (int i = 0; i < CLOSE_TEST_CONSUMERS; i++) consumed += cons_data[i].done;
+    
+    // Después del cierre no se acepta nada y no queda nada por extraer
+    int item;
+    bool refused = buffer_put(&buffer, 1) != 0 && buffer_get(&buffer, &item) != 0;
+    
+    bool ok = produced == consumed && produced == buffer.items_produced &&
+              (close_early || produced == CLOSE_TEST_PRODUCERS * CLOSE_TEST_ITEMS) &&
+              refused && exit_ms < CLOSE_MAX_EXIT_MS;
+    printf("%-7s %-6s %-10s %8d items, salida %.3f ms %s\n",
+           engine == PC_ENGINE_TICKET ? "tickets" : "mutex",
+           semaphore == PC_SEM_FUTEX ? "futex" : "sem_t",
+           close_early ? "en marcha" : "al final", consumed, exit_ms, ok ? "" : "❌");
+    
+    destroy_buffer(&buffer);
+    return ok;
+}
+
+// Test del cierre ordenado y de la parada inmediata
+int test_close_protocol() {
+    printf("\n=== Probando Cierre del Buffer ===\n");
+    
+    bool success = true;
+    PcEngine engines[] = {PC_ENGINE_MUTEX, PC_ENGINE_TICKET};
+    PcSemKind kinds[] = {PC_SEM_POSIX, PC_SEM_FUTEX};
+    for (int e = 0; e < 2; e++) {
+        for (int k = 0; k < 2; k++) {
+            success = run_close_case(engines[e], kinds[k], false) && success;
+            success = run_close_case(engines[e], kinds[k], true) && success;
+        }
+    }
+    
+    // buffer_shutdown despierta a consumidores bloqueados en un buffer vacío
+    ProducerConsumerBuffer buffer;
+    if (init_buffer(&buffer, BUFFER_SIZE) != 0) return -1;
+    pthread_t consumers[CLOSE_TEST_CONSUMERS];
+    CloseData cons_data[CLOSE_TEST_CONSUMERS];
+    for (int i = 0; i < CLOSE_TEST_CONSUMERS; i++) {
+        cons_data[i] = (CloseData){&buffer, 0, 0};
+        pthread_create(&consumers[i], NULL, close_consumer, &cons_data[i]);
+    }
+    usleep(10000);
+    long long start = latency_now_ns();
+    buffer_shutdown(&buffer);
+    for (int i = 0; i < CLOSE_TEST_CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+    double exit_ms = (latency_now_ns() - start) / 1e6;
+    printf("Parada inmediata: salida %.3f ms\n", exit_ms);
+    if (exit_ms >= CLOSE_MAX_EXIT_MS || buffer_put(&buffer, 1) == 0) {
+        printf("❌ La parada inmediata no liberó a los hilos\n");
+        success = false;
+    }
+    destroy_buffer(&buffer);
+    
+    printf("Cierre del buffer: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Emisor de trazas: la mitad de los eventos son DEBUG y la otra mitad INFO
+void *trace_emitter(void *arg) {
+    int thread_id = *(int *)arg;
+    for (int i = 0; i < TRACE_TEST_EVENTS; i++) {
+        if (i % 2) {
+            TRACE(TRACE_DEBUG, TRACE_ITEM_PUT, thread_id, i, i % BUFFER_SIZE);
+        } else {
+            TRACE(TRACE_INFO, TRACE_PRODUCER_START, thread_id, i, -1);
+        }
+    }
+    return NULL;
+}
+
+// Contar líneas escritas por el escritor de trazas
+static long long run_trace_emitters(FILE *out) {
+    pthread_t threads[TRACE_TEST_THREADS];
+    int ids[TRACE_TEST_THREADS];
+    
+    for (int i = 0; i < TRACE_TEST_THREADS; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, trace_emitter, &ids[i]);
+    }
+    for (int i = 0; i < TRACE_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    trace_flush();
+    
+    long long lines = 0;
+    int c;
+    rewind(out);
+    while ((c = fgetc(out)) != EOF) {
+        if (c == '\n') lines++;
+    }
+    return lines;
+}
+
+// Test de las trazas: filtro por nivel y conteo exacto (escritas + descartadas)
+int test_trace() {
+    printf("\n=== Probando Trazas Asíncronas ===\n");
+    
+    FILE *info_out = tmpfile();
+    FILE *debug_out = tmpfile();
+    if (!info_out || !debug_out) {
+        printf("❌ Error creando archivos temporales\n");
+        return -1;
+    }
+    
+    TraceLevel saved = trace_get_level();
+    long long emitted = (long long)TRACE_TEST_THREADS * TRACE_TEST_EVENTS;
+    bool success = true;
+    
+    // Con INFO los eventos DEBUG no llegan ni al anillo
+    trace_set_output(info_out);
+    trace_set_level(TRACE_INFO);
+    long long dropped = trace_dropped();
+    long long info_lines = run_trace_emitters(info_out);
+    long long info_dropped = trace_dropped() - dropped;
+    if (info_lines + info_dropped != emitted / 2) {
+        printf("❌ INFO: %lld escritos + %lld descartados, esperados %lld\n",
+               info_lines, info_dropped, emitted / 2);
+        success = false;
+    }
+    
+    // Con DEBUG se registra todo; lo que no entra en el anillo se cuenta
+    trace_set_output(debug_out);
+    trace_set_level(TRACE_DEBUG);
+    dropped = trace_dropped();
+    long long debug_lines = run_trace_emitters(debug_out);
+    long long debug_dropped = trace_dropped() - dropped;
+    if (debug_lines + debug_dropped != emitted) {
+        printf("❌ DEBUG: %lld escritos + %lld descartados, esperados %lld\n",
+               debug_lines, debug_dropped, emitted);
+        success = false;
+    }
+    
+    // Apagado: ningún evento
+    trace_set_level(TRACE_OFF);
+    long long off_lines = run_trace_emitters(debug_out) - debug_lines;
+    if (off_lines != 0) {
+        printf("❌ OFF: %lld eventos escritos\n", off_lines);
+        success = false;
+    }
+    
+    printf("INFO: %lld escritos, %lld descartados; DEBUG: %lld escritos, %lld descartados\n",
+           info_lines, info_dropped, debug_lines, debug_dropped);
+    
+    // Los descartes de esta prueba son a propósito: no informarlos al salir
+    trace_reset_dropped();
+    trace_set_output(NULL);
+    trace_set_level(saved);
+    fclose(info_out);
+    fclose(debug_out);
+    
+    printf("Trazas asíncronas: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Contextos del test de callbacks: los productores reparten un arreglo de
+// entrada y los consumidores acumulan lo que reciben
+typedef struct {
+    const int *input;
+    int count;
+    atomic_int next;
+} CallbackSource;
+
+typedef struct {
+    atomic_llong sum;
+    atomic_int count;
+} CallbackSink;
+
+static int source_produce(void *ctx, int thread_id, int index, int *item) {
+    (void)thread_id;
+    (void)index;
+    CallbackSource *source = (CallbackSource *)ctx;
+    int i = atomic_fetch_add(&source->next, 1);
+    if (i >= source->count) {
+        return 1;   // Entrada agotada
+    }
+    *item = source->input[i];
+    return 0;
+}
+
+static void sink_consume(void *ctx, int thread_id, int item) {
+    (void)thread_id;
+    CallbackSink *sink = (CallbackSink *)ctx;
+    atomic_fetch_add(&sink->sum, item);
+    atomic_fetch_add(&sink->count, 1);
+}
+
+// Test de callbacks: producer()/consumer() con trabajo propio y sin carga simulada
+int test_callbacks() {
+    printf("\n=== Probando Callbacks de Trabajo ===\n");
+    
+    int *input = malloc(CALLBACK_TEST_ITEMS * sizeof(int));
+    if (!input) {
+        printf("❌ Error reservando memoria\n");
+        return -1;
+    }
+    long long expected = 0;
+    for (int i = 0; i < CALLBACK_TEST_ITEMS; i++) {
+        input[i] = i * 7 + 3;
+        expected += input[i];
+    }
+    
+    ProducerConsumerBuffer buffer;
+    if (init_buffer(&buffer, BUFFER_SIZE) != 0) {
+        printf("❌ Error inicializando buffer\n");
+        free(input);
+        return -1;
+    }
+    
+    CallbackSource source = {input, CALLBACK_TEST_ITEMS, 0};
+    CallbackSink sink = {0, 0};
+    ThreadData prod_data[CALLBACK_TEST_PRODUCERS];
+    ThreadData cons_data[CALLBACK_TEST_CONSUMERS];
+    pthread_t prod_threads[CALLBACK_TEST_PRODUCERS];
+    pthread_t cons_threads[CALLBACK_TEST_CONSUMERS];
+    
+    long long start = latency_now_ns();
+    for (int i = 0; i < CALLBACK_TEST_CONSUMERS; i++) {
+        cons_data[i] = (ThreadData){&buffer, i, 0, 4, NULL, sink_consume, &sink, &pc_no_load};
+        pthread_create(&cons_threads[i], NULL, consumer, &cons_data[i]);
+    }
+    // items_to_produce < 0: cada productor sigue hasta que source_produce lo detiene
+    for (int i = 0; i < CALLBACK_TEST_PRODUCERS; i++) {
+        prod_data[i] = (ThreadData){&buffer, i, -1, 4, source_produce, NULL, &source, &pc_no_load};
+        pthread_create(&prod_threads[i], NULL, producer, &prod_data[i]);
+    }
+    for (int i = 0; i < CALLBACK_TEST_PRODUCERS; i++) {
+        pthread_join(prod_threads[i], NULL);
+    }
+    buffer_close(&buffer);
+    for (int i = 0; i < CALLBACK_TEST_CONSUMERS; i++) {
+        pthread_join(cons_threads[i], NULL);
+    }
+    double elapsed_ms = (latency_now_ns() - start) / 1e6;
+    
+    bool success = true;
+    if (atomic_load(&sink.count) != CALLBACK_TEST_ITEMS || atomic_load(&sink.sum) != expected) {
+        printf("❌ Consumidos %d items (suma %lld), esperados %d (suma %lld)\n",
+               atomic_load(&sink.count), (long long)atomic_load(&sink.sum),
+               CALLBACK_TEST_ITEMS, expected);
+        success = false;
+    }
+    if (buffer.items_produced != CALLBACK_TEST_ITEMS || buffer.items_consumed != CALLBACK_TEST_ITEMS) {
+        printf("❌ Contadores del buffer: %d producidos, %d consumidos\n",
+               buffer.items_produced, buffer.items_consumed);
+        success = false;
+    }
+    if (elapsed_ms > CALLBACK_MAX_MS) {
+        printf("❌ Sin carga simulada tardó %.1f ms (máximo %d)\n", elapsed_ms, CALLBACK_MAX_MS);
+        success = false;
+    }
+    printf("%d items en %.1f ms, suma %lld\n", atomic_load(&sink.count), elapsed_ms,
+           (long long)atomic_load(&sink.sum));
+    
+    destroy_buffer(&buffer);
+    free(input);
+    
+    printf("Callbacks de trabajo: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Etapas del test de pipeline: parse (fuente, source_produce) -> transform
+// -> write. transform es la lenta y descarta los múltiplos de 10.
+static int pipeline_transform(void *ctx, int worker_id, int item, int *out) {
+    (void)ctx;
+    (void)worker_id;
+    usleep(PIPELINE_SLOW_US);
+    if (item % 10 == 0) return 0;
+    *out = item * 2;
+    return 1;
+}
+
+static int pipeline_write(void *ctx, int worker_id, int item, int *out) {
+    (void)out;
+    sink_consume(ctx, worker_id, item);
+    return 0;
+}
+
+// Fuente que no se agota, para probar la parada inmediata
+static int pipeline_endless(void *ctx, int worker_id, int index, int *item) {
+    (void)ctx;
+    (void)worker_id;
+    *item = index;
+    return 0;
+}
+
+// Test del pipeline: cierre propagado por las etapas, resultado exacto,
+// detección del cuello de botella y parada inmediata
+int test_pipeline() {
+    printf("\n=== Probando Pipeline de Etapas ===\n");
+    
+    int *input = malloc(PIPELINE_TEST_ITEMS * sizeof(int));
+    if (!input) {
+        printf("❌ Error reservando memoria\n");
+        return -1;
+    }
+    long long expected_sum = 0;
+    int expected_count = 0;
+    for (int i = 0; i < PIPELINE_TEST_ITEMS; i++) {
+        input[i] = i;
+        if (i % 10 != 0) {
+            expected_sum += 2LL * i;
+            expected_count++;
+        }
+    }
+    
+    CallbackSource source = {input, PIPELINE_TEST_ITEMS, 0};
+    CallbackSink sink = {0, 0};
+    PcStageConfig stages[] = {
+        {"parse", 2, 0, 8, source_produce, NULL, &source},
+        {"transform", 2, 64, 4, NULL, pipeline_transform, NULL},
+        {"write", 1, 64, 8, NULL, pipeline_write, &sink},
+    };
+    
+    PcPipeline pipeline;
+    if (pc_pipeline_init(&pipeline, stages, 3) != 0 || pc_pipeline_start(&pipeline) != 0) {
+        printf("❌ Error iniciando pipeline\n");
+        free(input);
+        return -1;
+    }
+    // Vuelve sólo si el cierre llegó hasta la última etapa
+    pc_pipeline_wait(&pipeline);
+    pc_pipeline_report(&pipeline, stdout);
+    
+    bool success = true;
+    if (atomic_load(&sink.count) != expected_count || atomic_load(&sink.sum) != expected_sum) {
+        printf("❌ write recibió %d items (suma %lld), esperados %d (suma %lld)\n",
+               atomic_load(&sink.count), (long long)atomic_load(&sink.sum),
+               expected_count, expected_sum);
+        success = false;
+    }
+    
+    PcStageStats stats[3];
+    for (int i = 0; i < 3; i++) {
+        pc_pipeline_stats(&pipeline, i, &stats[i]);
+    }
+    if (stats[0].items_out != PIPELINE_TEST_ITEMS || stats[1].items_in != PIPELINE_TEST_ITEMS ||
+        stats[1].items_out != expected_count || stats[2].items_in != expected_count) {
+        printf("❌ Conteos por etapa: parse %lld, transform %lld -> %lld, write %lld\n",
+               stats[0].items_out, stats[1].items_in, stats[1].items_out, stats[2].items_in);
+        success = false;
+    }
+    if (stats[1].utilization <= stats[0].utilization || stats[1].utilization <= stats[2].utilization ||
+        stats[1].avg_occupancy <= stats[2].avg_occupancy) {
+        printf("❌ transform no aparece como cuello de botella\n");
+        success = false;
+    }
+    pc_pipeline_destroy(&pipeline);
+    free(input);
+    
+    // Parada inmediata con una fuente infinita
+    stages[0].produce = pipeline_endless;
+    if (pc_pipeline_init(&pipeline, stages, 3) != 0 || pc_pipeline_start(&pipeline) != 0) {
+        printf("❌ Error iniciando pipeline\n");
+        return -1;
+    }
+    usleep(20000);
+    long long stop_start = latency_now_ns();
+    pc_pipeline_stop(&pipeline);
+    pc_pipeline_wait(&pipeline);
+    double stop_ms = (latency_now_ns() - stop_start) / 1e6;
+    if (stop_ms > CLOSE_MAX_EXIT_MS) {
+        printf("❌ La parada tardó %.1f ms (máximo %d)\n", stop_ms, CLOSE_MAX_EXIT_MS);
+        success = false;
+    }
+    printf("Parada inmediata en %.2f ms\n", stop_ms);
+    pc_pipeline_destroy(&pipeline);
+    
+    printf("Pipeline de etapas: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Consumidor lento del test del grupo elástico
+static void pool_consume(void *ctx, int thread_id, int item) {
+    usleep(POOL_TEST_WORK_US);
+    sink_consume(ctx, thread_id, item);
+}
+
+// Test del grupo elástico: crece durante una ráfaga, vuelve al mínimo en
+// reposo y termina al cerrar el buffer sin perder items
+int test_consumer_pool() {
+    printf("\n=== Probando Grupo Elástico de Consumidores ===\n");
+    
+    ProducerConsumerBuffer buffer;
+    if (init_buffer(&buffer, 64) != 0) {
+        printf("❌ Error inicializando buffer\n");
+        return -1;
+    }
+    
+    CallbackSink sink = {0, 0};
+    PcPoolOptions options;
+    pc_pool_default_options(&options);
+    options.min_consumers = 1;
+    options.max_consumers = 4;
+    options.sample_ms = 5;
+    options.consume = pool_consume;
+    options.ctx = &sink;
+    
+    PcConsumerPool pool;
+    if (pc_pool_start(&pool, &buffer, &options) != 0) {
+        printf("❌ Error iniciando el grupo\n");
+        destroy_buffer(&buffer);
+        return -1;
+    }
+    
+    bool success = true;
+    
+    // La espera acotada que usan los consumidores vence con el buffer vacío
+    for (int kind = PC_SEM_POSIX; kind <= PC_SEM_FUTEX; kind++) {
+        ProducerConsumerBuffer empty_buffer;
+        PcBufferOptions empty_options = make_options(PC_ENGINE_MUTEX, (PcSemKind)kind, 4);
+        if (init_buffer_ex(&empty_buffer, &empty_options) != 0) {
+            success = false;
+            continue;
+        }
+        int item;
+        long long start = latency_now_ns();
+        int taken = buffer_get_timed(&empty_buffer, &item, NULL, 1, 20);
+        double waited_ms = (latency_now_ns() - start) / 1e6;
+        if (taken != 0 || waited_ms < 15) {
+            printf("❌ buffer_get_timed (%s): %d tras %.1f ms, esperado 0 tras 20 ms\n",
+                   kind == PC_SEM_POSIX ? "posix" : "futex", taken, waited_ms);
+            success = false;
+        }
+        destroy_buffer(&empty_buffer);
+    }
+    
+    long long expected = 0;
+    for (int i = 0; i < POOL_TEST_BURST; i++) {
+        buffer_put(&buffer, i);
+        expected += i;
+    }
+    int during_burst = atomic_load(&pool.peak);
+    
+    usleep(POOL_TEST_IDLE_MS * 1000);
+    int after_idle = pc_pool_active(&pool);
+    
+    buffer_close(&buffer);
+    pc_pool_wait(&pool);
+    
+    printf("Pico %d consumidores, %d tras la pausa; %lld creados, %lld retirados\n",
+           during_burst, after_idle, pool.spawned, pool.retired);
+    if (during_burst < 2) {
+        printf("❌ El grupo no creció durante la ráfaga\n");
+        success = false;
+    }
+    if (atomic_load(&pool.peak) > options.max_consumers || after_idle != options.min_consumers) {
+        printf("❌ Fuera de los límites: pico %d, en reposo %d (esperado %d)\n",
+               pool.peak, after_idle, options.min_consumers);
+        success = false;
+    }
+    if (atomic_load(&sink.count) != POOL_TEST_BURST || atomic_load(&sink.sum) != expected) {
+        printf("❌ Consumidos %d items (suma %lld), esperados %d (suma %lld)\n",
+               atomic_load(&sink.count), (long long)atomic_load(&sink.sum),
+               POOL_TEST_BURST, expected);
+        success = false;
+    }
+    
+    destroy_buffer(&buffer);
+    
+    printf("Grupo elástico: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Hilo del test del PRNG: sortea PRNG_TEST_DRAWS valores de un flujo fijo
+typedef struct {
+    uint64_t stream;
+    uint32_t draws[PRNG_TEST_DRAWS];
+} PrngDraws;
+
+static void *prng_drawer(void *arg) {
+    PrngDraws *d = (PrngDraws *)arg;
+    prng_thread_seed(d->stream);
+    for (int i = 0; i < PRNG_TEST_DRAWS; i++) {
+        d->draws[i] = prng_thread_below(1000);
+    }
+    return NULL;
+}
+
+// Test del PRNG por hilo: valor de referencia, rango y repetición exacta
+// con la misma semilla maestra y el mismo flujo, en cualquier hilo
+int test_prng() {
+    printf("\n=== Probando PRNG por Hilo ===\n");
+    
+    bool success = true;
+    uint64_t saved = prng_master_seed();
+    
+    // Primer valor de splitmix64 con semilla 0 (referencia publicada)
+    uint64_t state = 0;
+    if (prng_splitmix64(&state) != 0xe220a8397b1dcdafULL) {
+        printf("❌ splitmix64 no coincide con la referencia\n");
+        success = false;
+    }
+    
+    // Dos hilos con el mismo flujo sortean lo mismo; otro flujo, otra secuencia
+    static PrngDraws runs[3];
+    runs[0].stream = runs[1].stream = PRNG_STREAM(7, 1);
+    runs[2].stream = PRNG_STREAM(7, 2);
+    prng_set_master_seed(12345);
+    for (int i = 0; i < 3; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, prng_drawer, &runs[i]);
+        pthread_join(thread, NULL);
+    }
+    
+    int out_of_range = 0;
+    for (int r = 0; r < 3; r++) {
+        for (int i = 0; i < PRNG_TEST_DRAWS; i++) {
+            if (runs[r].draws[i] >= 1000) out_of_range++;
+        }
+    }
+    if (out_of_range > 0) {
+        printf("❌ %d valores fuera de [0, 1000)\n", out_of_range);
+        success = false;
+    }
+    if (memcmp(runs[0].draws, runs[1].draws, sizeof(runs[0].draws)) != 0) {
+        printf("❌ El mismo flujo no repitió la secuencia\n");
+        success = false;
+    }
+    if (memcmp(runs[0].draws, runs[2].draws, sizeof(runs[0].draws)) == 0) {
+        printf("❌ Flujos distintos dieron la misma secuencia\n");
+        success = false;
+    }
+    
+    // Otra semilla maestra cambia la secuencia del mismo flujo
+    PrngDraws reseeded = {runs[0].stream, {0}};
+    prng_set_master_seed(54321);
+    prng_drawer(&reseeded);
+    if (memcmp(runs[0].draws, reseeded.draws, sizeof(reseeded.draws)) == 0) {
+        printf("❌ La semilla maestra no cambió la secuencia\n");
+        success = false;
+    }
+    
+    prng_set_master_seed(saved);
+    
+    printf("PRNG por hilo: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Llenar un buffer sin consumidores y vaciarlo después: qué items sobreviven
+static bool check_overflow_case(PcEngine engine, PcOverflowPolicy policy, int first_kept,
+                                const char *label) {
+    ProducerConsumerBuffer buffer;
+    PcBufferOptions options = make_options(engine, PC_SEM_POSIX, OVERFLOW_TEST_CAPACITY);
+    options.overflow = policy;
+    if (init_buffer_ex(&buffer, &options) != 0) {
+        printf("❌ %s: error inicializando buffer\n", label);
+        return false;
+    }
+    
+    bool success = true;
+    for (int i = 0; i < OVERFLOW_TEST_PUTS; i++) {
+        if (buffer_put(&buffer, i) != 0) {
+            printf("❌ %s: buffer_put(%d) falló\n", label, i);
+            success = false;
+        }
+    }
+    
+    long long lost = buffer.items_dropped + buffer.items_overwritten;
+    if (lost != OVERFLOW_TEST_PUTS - OVERFLOW_TEST_CAPACITY ||
+        buffer_pending(&buffer) != OVERFLOW_TEST_CAPACITY) {
+        printf("❌ %s: %lld descartados y %d pendientes\n", label, lost, buffer_pending(&buffer));
+        success = false;
+    }
+    
+    buffer_close(&buffer);
+    int item, expected = first_kept;
+    while (buffer_get(&buffer, &item) == 0) {
+        if (item != expected) {
+            printf("❌ %s: se extrajo %d, esperado %d\n", label, item, expected);
+            success = false;
+        }
+        expected++;
+    }
+    if (expected != first_kept + OVERFLOW_TEST_CAPACITY) {
+        printf("❌ %s: se extrajeron %d items\n", label, expected - first_kept);
+        success = false;
+    }
+    
+    printf("%s: %lld rechazados, %d pisados\n", label, (long long)buffer.items_dropped,
+           buffer.items_overwritten);
+    destroy_buffer(&buffer);
+    return success;
+}
+
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int base;
+    int count;
+    unsigned char *seen;   // Sólo consumidores: un byte por item posible
+    int taken;
+} OverflowData;
+
+void *overflow_producer(void *arg) {
+    OverflowData *data = (OverflowData *)arg;
+    for (int i = 0; i < data->count; i++) {
+        buffer_put(data->buffer, data->base + i);
+    }
+    return NULL;
+}
+
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int result;          // Del segundo put, que espera por el límite de tasa
+    long long done_ns;
+} RateCloseData;
+
+void *rate_close_producer(void *arg) {
+    RateCloseData *data = (RateCloseData *)arg;
+    buffer_put(data->buffer, 0);
+    data->result = buffer_put(data->buffer, 1);
+    data->done_ns = latency_now_ns();
+    return NULL;
+}
+
+void *overflow_consumer(void *arg) {
+    OverflowData *data = (OverflowData *)arg;
+    int item;
+    while (buffer_get(data->buffer, &item) == 0) {
+        data->seen[item]++;
+        data->taken++;
+    }
+    return NULL;
+}
+
+// Test de las políticas de desborde y del límite de tasa
+int test_overflow_policies() {
+    printf("\n=== Probando Políticas de Desborde ===\n");
+    
+    // Descartar nuevos conserva los primeros; pisar viejos, los últimos
+    int kept_newest = OVERFLOW_TEST_PUTS - OVERFLOW_TEST_CAPACITY;
+    bool success = true;
+    if (!check_overflow_case(PC_ENGINE_MUTEX, PC_OVERFLOW_DROP_NEWEST, 0, "drop-newest")) {
+        success = false;
+    }
+    if (!check_overflow_case(PC_ENGINE_TICKET, PC_OVERFLOW_DROP_NEWEST, 0, "drop-newest (tickets)")) {
+        success = false;
+    }
+    if (!check_overflow_case(PC_ENGINE_MUTEX, PC_OVERFLOW_DROP_OLDEST, kept_newest, "drop-oldest")) {
+        success = false;
+    }
+    
+    // El motor ticket no puede pisar posiciones
+    ProducerConsumerBuffer buffer;
+    PcBufferOptions options = make_options(PC_ENGINE_TICKET, PC_SEM_POSIX, OVERFLOW_TEST_CAPACITY);
+    options.overflow = PC_OVERFLOW_DROP_OLDEST;
+    if (init_buffer_ex(&buffer, &options) == 0) {
+        printf("❌ drop-oldest aceptado con el motor ticket\n");
+        destroy_buffer(&buffer);
+        success = false;
+    }
+    
+    // Pisado concurrente: cada item sale una sola vez o se cuenta como pisado
+    options = make_options(PC_ENGINE_MUTEX, PC_SEM_FUTEX, OVERFLOW_TEST_CAPACITY);
+    options.overflow = PC_OVERFLOW_DROP_OLDEST;
+    if (init_buffer_ex(&buffer, &options) != 0) {
+        return -1;
+    }
+    int total = 2 * OVERFLOW_STRESS_ITEMS;
+    unsigned char *seen[2] = {calloc(total, 1), calloc(total, 1)};
+    OverflowData producers[2], consumers[2];
+    pthread_t threads[4];
+    for (int i = 0; i < 2; i++) {
+        consumers[i] = (OverflowData){&buffer, 0, 0, seen[i], 0};
+        producers[i] = (OverflowData){&buffer, i * OVERFLOW_STRESS_ITEMS, OVERFLOW_STRESS_ITEMS, NULL, 0};
+        pthread_create(&threads[i], NULL, overflow_consumer, &consumers[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[2 + i], NULL, overflow_producer, &producers[i]);
+    }
+    pthread_join(threads[2], NULL);
+    pthread_join(threads[3], NULL);
+    buffer_close(&buffer);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    
+    int duplicates = 0;
+    for (int i = 0; i < total; i++) {
+        if (seen[0][i] + seen[1][i] > 1) duplicates++;
+    }
+    int taken = consumers[0].taken + consumers[1].taken;
+    if (duplicates > 0 || taken + buffer.items_overwritten != total ||
+        buffer.items_produced != total) {
+        printf("❌ Pisado concurrente: %d consumidos + %d pisados de %d, %d duplicados\n",
+               taken, buffer.items_overwritten, total, duplicates);
+        success = false;
+    }
+    printf("Pisado concurrente: %d consumidos, %d pisados\n", taken, buffer.items_overwritten);
+    free(seen[0]);
+    free(seen[1]);
+    destroy_buffer(&buffer);
+    
+    // Token bucket: la ráfaga pasa enseguida y el resto al ritmo pedido
+    options = make_options(PC_ENGINE_MUTEX, PC_SEM_POSIX, RATE_TEST_ITEMS);
+    options.rate_limit = RATE_TEST_LIMIT;
+    options.rate_burst = RATE_TEST_BURST;
+    if (init_buffer_ex(&buffer, &options) != 0) {
+        return -1;
+    }
+    long long start = latency_now_ns();
+    for (int i = 0; i < RATE_TEST_ITEMS; i++) {
+        buffer_put(&buffer, i);
+    }
+    double elapsed_ms = (latency_now_ns() - start) / 1e6;
+    double expected_ms = (RATE_TEST_ITEMS - RATE_TEST_BURST) / RATE_TEST_LIMIT * 1000;
+    if (elapsed_ms < expected_ms * 0.9 || elapsed_ms > expected_ms * 4 || buffer.rate_waits == 0) {
+        printf("❌ Límite de tasa: %d items en %.1f ms, esperado ~%.1f ms\n",
+               RATE_TEST_ITEMS, elapsed_ms, expected_ms);
+        success = false;
+    }
+    printf("Límite de tasa: %d items en %.1f ms (esperado ~%.1f ms), %lld esperas\n",
+           RATE_TEST_ITEMS, elapsed_ms, expected_ms, (long long)buffer.rate_waits);
+    destroy_buffer(&buffer);
+    
+    // Un lote que no entra de una vez se cobra una sola vez, no lo que
+    // falta en cada ronda: 110 items por un buffer de 4 que pisa los viejos
+    options = make_options(PC_ENGINE_MUTEX, PC_SEM_POSIX, OVERFLOW_TEST_CAPACITY);
+    options.overflow = PC_OVERFLOW_DROP_OLDEST;
+    options.rate_limit = RATE_TEST_LIMIT;
+    options.rate_burst = RATE_TEST_BURST;
+    if (init_buffer_ex(&buffer, &options) != 0) {
+        return -1;
+    }
+    int batch[RATE_TEST_ITEMS];
+    for (int i = 0; i < RATE_TEST_ITEMS; i++) {
+        batch[i] = i;
+    }
+    start = latency_now_ns();
+    bool batch_ok = buffer_put_batch(&buffer, batch, RATE_TEST_ITEMS) == 0;
+    elapsed_ms = (latency_now_ns() - start) / 1e6;
+    long long charged = (atomic_load(&buffer.rate_tat) - start) / buffer.rate_interval_ns;
+    if (!batch_ok || charged > RATE_TEST_ITEMS || elapsed_ms > expected_ms * 4) {
+        printf("❌ Lote con límite de tasa: cobró %lld items por %d (%.1f ms)\n",
+               charged, RATE_TEST_ITEMS, elapsed_ms);
+        success = false;
+    }
+    printf("Lote de %d items por %d slots: cobró %lld en %.1f ms\n", RATE_TEST_ITEMS,
+           OVERFLOW_TEST_CAPACITY, charged, elapsed_ms);
+    
+    // Cerrado: falla enseguida sin reservar ni dormir por tokens
+    buffer_close(&buffer);
+    long long tat = atomic_load(&buffer.rate_tat);
+    start = latency_now_ns();
+    bool refused = buffer_put_batch(&buffer, batch, RATE_TEST_ITEMS) != 0 &&
+                   buffer_put(&buffer, 0) != 0;
+    elapsed_ms = (latency_now_ns() - start) / 1e6;
+    if (!refused || atomic_load(&buffer.rate_tat) != tat || elapsed_ms > expected_ms / 2) {
+        printf("❌ Límite de tasa con el buffer cerrado: durmió %.1f ms\n", elapsed_ms);
+        success = false;
+    }
+    destroy_buffer(&buffer);
+    
+    // Cerrar mientras un productor espera tokens lo despierta enseguida, no
+    // al terminar la espera
+    options = make_options(PC_ENGINE_MUTEX, PC_SEM_POSIX, OVERFLOW_TEST_CAPACITY);
+    options.rate_limit = RATE_CLOSE_TEST_LIMIT;
+    if (init_buffer_ex(&buffer, &options) != 0) {
+        return -1;
+    }
+    RateCloseData waiter = {&buffer, 0, 0};
+    pthread_t waiter_thread;
+    pthread_create(&waiter_thread, NULL, rate_close_producer, &waiter);
+    usleep(RATE_CLOSE_TEST_MS * 1000);
+    long long closed_at = latency_now_ns();
+    buffer_close(&buffer);
+    pthread_join(waiter_thread, NULL);
+    double exit_ms = (waiter.done_ns - closed_at) / 1e6;
+    if (waiter.result == 0 || exit_ms > RATE_CLOSE_TEST_MAX_MS) {
+        printf("❌ Cierre durante la espera de tokens: salió en %.1f ms (put = %d)\n",
+               exit_ms, waiter.result);
+        success = false;
+    }
+    printf("Cierre durante la espera de tokens: salió en %.2f ms\n", exit_ms);
+    destroy_buffer(&buffer);
+    
+    printf("Políticas de desborde: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
+// Datos de los hilos del barrido de capacidad
+typedef struct {
+    ProducerConsumerBuffer *buffer;
+    int count;
+    LatencyHistogram *latency;   // Sólo consumidores
+} SweepData;
+
+void *sweep_producer(void *arg) {
+    SweepData *data = (SweepData *)arg;
+    for (int i = 0; i < data->count; i++) {
+        buffer_put(data->buffer, i);
+    }
+    return NULL;
+}
+
+void *sweep_consumer(void *arg) {
+    SweepData *data = (SweepData *)arg;
+    int item;
+    long long stamp;
+    for (int i = 0; i < data->count; i++) {
+        if (buffer_get_stamped(data->buffer, &item, &stamp) != 0) break;
+        latency_histogram_record(data->latency, latency_now_ns() - stamp);
+    }
+    return NULL;
+}
+
+// Barrido de capacidades sin retardos simulados: throughput y latencia en
+// buffer por capacidad, para ubicar el punto a partir del cual agrandar el
+// buffer ya no mejora el throughput y sólo suma latencia
+int test_capacity_sweep() {
+    printf("\n=== Barrido de Capacidad del Buffer ===\n");
+    
+    double best_throughput = 0;
+    double throughputs[16];
+    int capacities[16];
+    int num_capacities = 0;
+    bool success = true;
+    
+    printf("%9s %14s %12s %12s\n", "capacidad", "items/s", "p50 (µs)", "p99 (µs)");
+    
+    for (int capacity = 1; capacity <= SWEEP_MAX_CAPACITY; capacity *= 4) {
+        ProducerConsumerBuffer buffer;
+        if (init_buffer(&buffer, capacity) != 0) {
+            printf("❌ Error inicializando buffer de capacidad %d\n", capacity);
+            return -1;
+        }
+        
+        pthread_t threads[2 * SWEEP_THREADS];
+        SweepData data[2 * SWEEP_THREADS];
+        LatencyHistogram *merged = latency_histogram_create();
+        
+        long long start = latency_now_ns();
+        for (int i = 0; i < 2 * SWEEP_THREADS; i++) {
+            data[i].buffer = &buffer;
+            data[i].count = SWEEP_ITEMS / SWEEP_THREADS;
+            data[i].latency = i < SWEEP_THREADS ? latency_histogram_create() : NULL;
+            pthread_create(&threads[i], NULL, i < SWEEP_THREADS ? sweep_consumer : sweep_producer,
+                           &data[i]);
+        }
+        for (int i = 0; i < 2 * SWEEP_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        double seconds = (latency_now_ns() - start) / 1e9;
+        
+        for (int i = 0; i < SWEEP_THREADS; i++) {
+            latency_histogram_merge(merged, data[i].latency);
+            latency_histogram_free(data[i].latency);
+        }
+        
+        double throughput = SWEEP_ITEMS / seconds;
+        printf("%9d %14.0f %12.1f %12.1f\n", capacity, throughput,
+               latency_histogram_percentile(merged, 0.50) / 1000.0,
+               latency_histogram_percentile(merged, 0.99) / 1000.0);
+        
+        if (merged->total != SWEEP_ITEMS || buffer.items_consumed != SWEEP_ITEMS ||
+            !is_buffer_empty(&buffer)) {
+            printf("❌ Capacidad %d: se consumieron %d de %d items\n",
+                   capacity, buffer.items_consumed, SWEEP_ITEMS);
+            success = false;
+        }
+        
+        capacities[num_capacities] = capacity;
+        throughputs[num_capacities++] = throughput;
+        if (throughput > best_throughput) best_throughput = throughput;
+        
+        latency_histogram_free(merged);
+        destroy_buffer(&buffer);
+    }
+    
+    // Rodilla: menor capacidad con al menos 90% del mejor throughput
+    for (int i = 0; i < num_capacities; i++) {
+        if (throughputs[i] >= 0.9 * best_throughput) {
+            printf("Rodilla de la curva: capacidad %d (%.0f%% del mejor throughput)\n",
+                   capacities[i], throughputs[i] * 100 / best_throughput);
+            break;
+        }
+    }
+    
+    printf("Barrido de capacidad: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
+    return success ? 0 : -1;
+}
+
 // Test multi-threaded completo
 int test_multi_threaded() {
     printf("\n=== Probando Operaciones Multi-threaded ===\n");
     
     ProducerConsumerBuffer buffer;
-    if (init_buffer(&buffer) != 0) {
+    if (init_buffer(&buffer, BUFFER_SIZE) != 0) {
         printf("❌ Error inicializando buffer\n");
         return -1;
     }
@@ -107,7 +1480,7 @@ int test_multi_threaded() {
     for (int i = 0; i < NUM_CONSUMERS; i++) {
         if (pthread_create(&consumer_threads[i], NULL, consumer, &consumer_data[i]) != 0) {
             perror("Error creando thread consumidor");
-            buffer.shutdown = true;
+            buffer_shutdown(&buffer);
             return -1;
         }
         printf("Consumidor %d iniciado\n", i);
@@ -117,7 +1490,7 @@ int test_multi_threaded() {
     for (int i = 0; i < NUM_PRODUCERS; i++) {
         if (pthread_create(&producer_threads[i], NULL, producer, &producer_data[i]) != 0) {
             perror("Error creando thread productor");
-            buffer.shutdown = true;
+            buffer_shutdown(&buffer);
             return -1;
         }
         printf("Productor %d iniciado\n", i);
@@ -130,22 +1503,8 @@ int test_multi_threaded() {
     
     printf("\nTodos los productores han terminado. Esperando a consumidores...\n");
     
-    // Esperar un tiempo para que los consumidores procesen todo
-    int timeout = 10; // 10 segundos máximo
-    while (timeout > 0 && buffer.items_consumed < buffer.items_produced) {
-        sleep(1);
-        timeout--;
-        printf("Esperando... Producidos: %d, Consumidos: %d\n", 
-               buffer.items_produced, buffer.items_consumed);
-    }
-    
-    // Terminar consumidores
-    buffer.shutdown = true;
-    
-    // Despertar a todos los consumidores
-    for (int i = 0; i < NUM_CONSUMERS; i++) {
-        sem_post(&buffer.full);
-    }
+    // Cerrar: los consumidores procesan lo que queda y salen solos
+    buffer_close(&buffer);
     
     // Esperar a que terminen los consumidores
     for (int i = 0; i < NUM_CONSUMERS; i++) {
@@ -154,9 +1513,21 @@ int test_multi_threaded() {
     
     print_statistics(&buffer);
     
+    // Cada item consumido debe tener su latencia registrada
+    LatencyHistogram *queue_delay = latency_histogram_create();
+    LatencyHistogram *end_to_end = latency_histogram_create();
+    long long measured = -1;
+    if (queue_delay && end_to_end) {
+        buffer_latency_snapshot(&buffer, queue_delay, end_to_end);
+        measured = queue_delay->total == end_to_end->total ? queue_delay->total : -1;
+    }
+    latency_histogram_free(queue_delay);
+    latency_histogram_free(end_to_end);
+    
     int expected = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
     bool success = (buffer.items_produced == expected && 
-                   buffer.items_consumed == expected);
+                   buffer.items_consumed == expected &&
+                   measured == expected);
     
     printf("\nTotal esperado: %d\n", expected);
     printf("Prueba multi-threaded: %s\n", success ? "✅ EXITOSA" : "❌ FALLÓ");
@@ -171,8 +1542,11 @@ int main() {
     printf("Programa de Prueba Producer-Consumer\n");
     printf("===================================\n");
     
-    // Configurar semilla para números aleatorios
-    srand(time(NULL));
+    // Semilla maestra del PRNG por hilo; LAB_SEED=<semilla> repite los tiempos
+    printf("Semilla: %llu\n", (unsigned long long)prng_init_from_env());
+    
+    // Nivel de trazas desde PC_TRACE (off, info o debug)
+    trace_init_from_env();
     
     // Configurar manejador de señales
     signal(SIGINT, signal_handler);
@@ -185,6 +1559,54 @@ int main() {
         result = -1;
     }
     
+    if (test_latency_histogram() != 0) {
+        result = -1;
+    }
+    
+    if (test_trace() != 0) {
+        result = -1;
+    }
+    
+    if (test_batch_operations() != 0) {
+        result = -1;
+    }
+    
+    if (test_ticket_engine() != 0) {
+        result = -1;
+    }
+    
+    if (test_futex_semaphore() != 0) {
+        result = -1;
+    }
+    
+    if (test_close_protocol() != 0) {
+        result = -1;
+    }
+    
+    if (test_callbacks() != 0) {
+        result = -1;
+    }
+    
+    if (test_pipeline() != 0) {
+        result = -1;
+    }
+    
+    if (test_consumer_pool() != 0) {
+        result = -1;
+    }
+    
+    if (test_prng() != 0) {
+        result = -1;
+    }
+    
+    if (test_overflow_policies() != 0) {
+        result = -1;
+    }
+    
+    if (test_capacity_sweep() != 0) {
+        result = -1;
+    }
+    
     if (test_multi_threaded() != 0) {
         result = -1;
     }
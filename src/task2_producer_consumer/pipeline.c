@@ -0,0 +1,285 @@
+#include "pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+
+static ProducerConsumerBuffer *next_input(PcPipeline *pipeline, int index) {
+    return index + 1 < pipeline->num_stages ? &pipeline->stages[index + 1].input : NULL;
+}
+
+// El último hilo de una etapa cierra la entrada de la siguiente: ésta vacía
+// lo que quede y, al terminar, cierra a su vez la que le sigue
+static void stage_worker_done(PcPipeline *pipeline, int index) {
+    PcStage *stage = &pipeline->stages[index];
+
+    if (atomic_fetch_sub(&stage->active, 1) == 1) {
+        atomic_store(&stage->end_ns, latency_now_ns());
+        buffer_close(next_input(pipeline, index));
+    }
+}
+
+// Ocupación de la entrada al llegar el lote (antes de retirarlo)
+static void sample_occupancy(PcStage *stage, int taken) {
+    int pending = buffer_pending(&stage->input) + taken;
+    if (pending > stage->input.capacity) pending = stage->input.capacity;
+    if (pending < 0) pending = 0;
+
+    atomic_fetch_add_explicit(&stage->occupancy_sum, pending, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stage->occupancy_samples, 1, memory_order_relaxed);
+
+    int max = atomic_load_explicit(&stage->occupancy_max, memory_order_relaxed);
+    while (pending > max &&
+           !atomic_compare_exchange_weak_explicit(&stage->occupancy_max, &max, pending,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Hilo de la fuente: genera ráfagas hasta que produce diga basta
+static void *source_worker(void *arg) {
+    PcStageWorker *worker = (PcStageWorker *)arg;
+    PcPipeline *pipeline = worker->pipeline;
+    PcStage *stage = &pipeline->stages[worker->index];
+    ProducerConsumerBuffer *next = next_input(pipeline, worker->index);
+    int batch = stage->config.batch;
+
+    int items[PC_MAX_BATCH];
+    bool exhausted = false;
+    for (int index = 0; !exhausted && !atomic_load(&pipeline->stopped); ) {
+        long long start = latency_now_ns();
+        int made = 0;
+        while (made < batch) {
+            if (stage->config.produce(stage->config.ctx, worker->worker_id, index, &items[made]) != 0) {
+                exhausted = true;
+                break;
+            }
+            made++;
+            index++;
+        }
+        atomic_fetch_add_explicit(&stage->busy_ns, latency_now_ns() - start, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stage->items_in, made, memory_order_relaxed);
+
+        if (made > 0 && next) {
+            if (buffer_put_batch(next, items, made) != 0) break;
+            atomic_fetch_add_explicit(&stage->items_out, made, memory_order_relaxed);
+        }
+    }
+
+    stage_worker_done(pipeline, worker->index);
+    return NULL;
+}
+
+// Hilo de una etapa intermedia o final: toma, procesa y pasa a la siguiente
+static void *stage_worker(void *arg) {
+    PcStageWorker *worker = (PcStageWorker *)arg;
+    PcPipeline *pipeline = worker->pipeline;
+    PcStage *stage = &pipeline->stages[worker->index];
+    ProducerConsumerBuffer *next = next_input(pipeline, worker->index);
+    int batch = stage->config.batch;
+
+    int items[PC_MAX_BATCH];
+    int results[PC_MAX_BATCH];
+    for (;;) {
+        int taken = buffer_get_batch(&stage->input, items, NULL, batch);
+        if (taken < 0) break;
+        sample_occupancy(stage, taken);
+
+        long long start = latency_now_ns();
+        int emitted = 0;
+        for (int j = 0; j < taken; j++) {
+            if (stage->config.process(stage->config.ctx, worker->worker_id, items[j],
+                                      &results[emitted])) {
+                emitted++;
+            }
+        }
+        atomic_fetch_add_explicit(&stage->busy_ns, latency_now_ns() - start, memory_order_relaxed);
+        atomic_fetch_add_explicit(&stage->items_in, taken, memory_order_relaxed);
+
+        if (emitted > 0) {
+            if (next && buffer_put_batch(next, results, emitted) != 0) break;
+            atomic_fetch_add_explicit(&stage->items_out, emitted, memory_order_relaxed);
+        }
+    }
+
+    stage_worker_done(pipeline, worker->index);
+    return NULL;
+}
+
+int pc_pipeline_init(PcPipeline *pipeline, const PcStageConfig *stages, int num_stages) {
+    if (!pipeline || !stages || num_stages <= 0 || num_stages > PC_PIPELINE_MAX_STAGES) {
+        fprintf(stderr, "Error: pipeline inválido (%d etapas)\n", num_stages);
+        return -1;
+    }
+
+    for (int i = 0; i < num_stages; i++) {
+        const PcStageConfig *config = &stages[i];
+        if (config->workers <= 0 || config->workers > PC_PIPELINE_MAX_WORKERS ||
+            config->batch > PC_MAX_BATCH || config->capacity < 0 ||
+            (i == 0 ? !config->produce : !config->process)) {
+            fprintf(stderr, "Error: etapa %d (%s) inválida\n", i,
+                    config->name ? config->name : "?");
+            return -1;
+        }
+    }
+
+    pipeline->stages = calloc(num_stages, sizeof(PcStage));
+    if (!pipeline->stages) {
+        fprintf(stderr, "Error: No se pudo reservar memoria para el pipeline\n");
+        return -1;
+    }
+    pipeline->num_stages = num_stages;
+    pipeline->start_ns = 0;
+    atomic_init(&pipeline->stopped, false);
+
+    for (int i = 0; i < num_stages; i++) {
+        PcStage *stage = &pipeline->stages[i];
+        stage->config = stages[i];
+        if (stage->config.batch < 1) stage->config.batch = 1;
+        if (i == 0) {
+            stage->config.capacity = 0;
+        } else if (stage->config.capacity == 0) {
+            stage->config.capacity = BUFFER_SIZE;
+        }
+
+        atomic_init(&stage->active, 0);
+        atomic_init(&stage->items_in, 0);
+        atomic_init(&stage->items_out, 0);
+        atomic_init(&stage->busy_ns, 0);
+        atomic_init(&stage->occupancy_sum, 0);
+        atomic_init(&stage->occupancy_samples, 0);
+        atomic_init(&stage->occupancy_max, 0);
+        atomic_init(&stage->end_ns, 0);
+
+        if (i > 0 && init_buffer(&stage->input, stage->config.capacity) != 0) {
+            for (int j = 1; j < i; j++) {
+                destroy_buffer(&pipeline->stages[j].input);
+            }
+            free(pipeline->stages);
+            pipeline->stages = NULL;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int pc_pipeline_start(PcPipeline *pipeline) {
+    if (!pipeline || !pipeline->stages) return -1;
+
+    pipeline->start_ns = latency_now_ns();
+
+    // Los consumidores de cada etapa arrancan antes que quienes la alimentan
+    for (int i = pipeline->num_stages - 1; i >= 0; i--) {
+        PcStage *stage = &pipeline->stages[i];
+        atomic_store(&stage->active, stage->config.workers);
+
+        for (int w = 0; w < stage->config.workers; w++) {
+            stage->workers[w] = (PcStageWorker){pipeline, i, w};
+            if (pthread_create(&stage->threads[w], NULL, i == 0 ? source_worker : stage_worker,
+                               &stage->workers[w]) != 0) {
+                perror("Error creando hilo del pipeline");
+                // Descontar los que no se crearon y bajar todo
+                atomic_fetch_sub(&stage->active, stage->config.workers - w - 1);
+                stage_worker_done(pipeline, i);
+                pc_pipeline_stop(pipeline);
+                pc_pipeline_wait(pipeline);
+                return -1;
+            }
+            stage->started++;
+        }
+    }
+
+    return 0;
+}
+
+void pc_pipeline_wait(PcPipeline *pipeline) {
+    if (!pipeline || !pipeline->stages) return;
+
+    // De la fuente hacia el final, que es el orden en que terminan
+    for (int i = 0; i < pipeline->num_stages; i++) {
+        PcStage *stage = &pipeline->stages[i];
+        for (int w = 0; w < stage->started; w++) {
+            pthread_join(stage->threads[w], NULL);
+        }
+        stage->started = 0;
+    }
+}
+
+void pc_pipeline_stop(PcPipeline *pipeline) {
+    if (!pipeline || !pipeline->stages) return;
+
+    atomic_store(&pipeline->stopped, true);
+    for (int i = 1; i < pipeline->num_stages; i++) {
+        buffer_shutdown(&pipeline->stages[i].input);
+    }
+}
+
+void pc_pipeline_stats(PcPipeline *pipeline, int index, PcStageStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!pipeline || !pipeline->stages || index < 0 || index >= pipeline->num_stages) return;
+
+    PcStage *stage = &pipeline->stages[index];
+    stats->name = stage->config.name ? stage->config.name : "?";
+    stats->workers = stage->config.workers;
+    stats->capacity = stage->config.capacity;
+    stats->items_in = atomic_load(&stage->items_in);
+    stats->items_out = atomic_load(&stage->items_out);
+
+    long long end = atomic_load(&stage->end_ns);
+    if (end == 0) end = latency_now_ns();
+    stats->seconds = pipeline->start_ns ? (end - pipeline->start_ns) / 1e9 : 0.0;
+    if (stats->seconds > 0) {
+        stats->throughput = stats->items_in / stats->seconds;
+        stats->utilization = atomic_load(&stage->busy_ns) / 1e9 /
+                             (stats->seconds * stats->workers);
+    }
+
+    long long samples = atomic_load(&stage->occupancy_samples);
+    if (samples > 0 && stats->capacity > 0) {
+        stats->avg_occupancy = (double)atomic_load(&stage->occupancy_sum) / samples / stats->capacity;
+        stats->max_occupancy = (double)atomic_load(&stage->occupancy_max) / stats->capacity;
+    }
+}
+
+void pc_pipeline_report(PcPipeline *pipeline, FILE *out) {
+    if (!pipeline || !pipeline->stages) return;
+    if (!out) out = stdout;
+
+    PcStageStats stats[PC_PIPELINE_MAX_STAGES];
+    int bottleneck = 0;
+    for (int i = 0; i < pipeline->num_stages; i++) {
+        pc_pipeline_stats(pipeline, i, &stats[i]);
+        if (stats[i].utilization > stats[bottleneck].utilization) {
+            bottleneck = i;
+        }
+    }
+
+    fprintf(out, "\n=== Pipeline (%d etapas) ===\n", pipeline->num_stages);
+    fprintf(out, "%-12s %5s %6s %10s %10s %12s %6s %9s %9s\n", "etapa", "hilos", "cap",
+            "entrada", "salida", "items/s", "util", "cola prom", "cola máx");
+    for (int i = 0; i < pipeline->num_stages; i++) {
+        PcStageStats *s = &stats[i];
+        if (i == 0) {
+            fprintf(out, "%-12s %5d %6s", s->name, s->workers, "-");
+        } else {
+            fprintf(out, "%-12s %5d %6d", s->name, s->workers, s->capacity);
+        }
+        fprintf(out, " %10lld %10lld %12.0f %5.0f%%", s->items_in, s->items_out,
+                s->throughput, s->utilization * 100);
+        if (i == 0) {
+            fprintf(out, " %9s %9s", "-", "-");
+        } else {
+            fprintf(out, " %8.0f%% %8.0f%%", s->avg_occupancy * 100, s->max_occupancy * 100);
+        }
+        fprintf(out, "%s\n", i == bottleneck ? "  <- cuello de botella" : "");
+    }
+}
+
+void pc_pipeline_destroy(PcPipeline *pipeline) {
+    if (!pipeline || !pipeline->stages) return;
+
+    for (int i = 1; i < pipeline->num_stages; i++) {
+        destroy_buffer(&pipeline->stages[i].input);
+    }
+    free(pipeline->stages);
+    pipeline->stages = NULL;
+    pipeline->num_stages = 0;
+}
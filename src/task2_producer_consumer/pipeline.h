@@ -0,0 +1,104 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "producer_consumer.h"
+#include <stdio.h>
+
+// Pipeline de N etapas encadenadas con buffers acotados, p. ej.
+// parse -> transform -> write. La etapa 0 es la fuente (genera items con
+// produce); cada etapa siguiente tiene su propio buffer de entrada y su
+// propio grupo de hilos que toman items, los procesan con process y pasan
+// el resultado a la etapa siguiente.
+//
+// El cierre se propaga solo: cuando termina el último hilo de una etapa se
+// cierra el buffer de la siguiente, que vacía lo pendiente y termina a su
+// vez. pc_pipeline_stop, en cambio, corta todo de inmediato.
+//
+// El reporte muestra por etapa el throughput, la utilización de sus hilos
+// (tiempo dentro del callback) y la ocupación de su buffer de entrada; la
+// etapa cuello de botella tiene la utilización más alta y la cola de
+// entrada casi llena, y es la que conviene darle más hilos.
+#define PC_PIPELINE_MAX_STAGES 16
+#define PC_PIPELINE_MAX_WORKERS 64   // Por etapa
+
+// Procesar un item de una etapa intermedia o final. Devuelve 1 si deja un
+// resultado en *out para la etapa siguiente, 0 si el item se descarta (en la
+// última etapa el resultado se ignora).
+typedef int (*PcStageFn)(void *ctx, int worker_id, int item, int *out);
+
+typedef struct {
+    const char *name;
+    int workers;                // Hilos de la etapa (>= 1)
+    int capacity;               // Buffer de entrada (0 = BUFFER_SIZE; se ignora en la fuente)
+    int batch;                  // Items por operación del buffer (0 o 1 = de a uno)
+    PcProduceFn produce;        // Sólo la etapa 0
+    PcStageFn process;          // Etapas 1..N-1
+    void *ctx;                  // Contexto para produce/process
+} PcStageConfig;
+
+// Estadísticas de una etapa, válidas al terminar (o en cualquier momento
+// como aproximación)
+typedef struct {
+    const char *name;
+    int workers;
+    int capacity;               // 0 en la fuente
+    long long items_in;         // Items tomados de la entrada (generados en la fuente)
+    long long items_out;        // Items pasados a la siguiente etapa
+    double seconds;             // Desde el arranque hasta que terminó el último hilo
+    double throughput;          // items_in / seconds
+    double utilization;         // Fracción del tiempo de los hilos dentro del callback
+    double avg_occupancy;       // Ocupación media del buffer de entrada (0..1)
+    double max_occupancy;
+} PcStageStats;
+
+typedef struct PcPipeline PcPipeline;
+
+typedef struct {
+    PcPipeline *pipeline;
+    int index;
+    int worker_id;
+} PcStageWorker;
+
+typedef struct {
+    PcStageConfig config;
+    ProducerConsumerBuffer input;   // Sin usar en la fuente
+    pthread_t threads[PC_PIPELINE_MAX_WORKERS];
+    PcStageWorker workers[PC_PIPELINE_MAX_WORKERS];
+    int started;                    // Hilos creados
+    atomic_int active;              // Hilos que todavía no terminaron
+    atomic_llong items_in;
+    atomic_llong items_out;
+    atomic_llong busy_ns;
+    atomic_llong occupancy_sum;     // Items en la entrada, sumados en cada toma
+    atomic_llong occupancy_samples;
+    atomic_int occupancy_max;
+    atomic_llong end_ns;
+} PcStage;
+
+struct PcPipeline {
+    PcStage *stages;
+    int num_stages;
+    atomic_bool stopped;
+    long long start_ns;
+};
+
+// Crear las etapas y sus buffers; 0 o -1 (configuración inválida o sin memoria)
+int pc_pipeline_init(PcPipeline *pipeline, const PcStageConfig *stages, int num_stages);
+
+// Lanzar los hilos de todas las etapas, de la última a la fuente
+int pc_pipeline_start(PcPipeline *pipeline);
+
+// Esperar a que la fuente se agote y el resto de las etapas se vacíe
+void pc_pipeline_wait(PcPipeline *pipeline);
+
+// Parada inmediata: la fuente deja de generar y los items en vuelo se pierden
+void pc_pipeline_stop(PcPipeline *pipeline);
+
+void pc_pipeline_stats(PcPipeline *pipeline, int stage, PcStageStats *stats);
+
+// Tabla por etapa, marcando el cuello de botella
+void pc_pipeline_report(PcPipeline *pipeline, FILE *out);
+
+void pc_pipeline_destroy(PcPipeline *pipeline);
+
+#endif // PIPELINE_H
@@ -1,52 +1,175 @@
 #define _DEFAULT_SOURCE
 #include "producer_consumer.h"
+#include "../common/prng.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+// Menor potencia de 2 >= v
+static int round_up_pow2(int v) {
+    int p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+// Reservar un arreglo alineado a línea de caché; los grandes se alinean a
+// 2 MB y se ofrecen al kernel como huge pages (si no las hay, sigue normal)
+static void *alloc_ring(size_t bytes) {
+    size_t align = bytes >= PC_HUGEPAGE_BYTES ? PC_HUGEPAGE_BYTES : PC_CACHE_LINE;
+    bytes = (bytes + align - 1) & ~(align - 1);
+
+    void *ptr = aligned_alloc(align, bytes);
+#ifdef MADV_HUGEPAGE
+    if (ptr && align == PC_HUGEPAGE_BYTES) {
+        madvise(ptr, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    return ptr;
+}
 
 
+static void free_storage(ProducerConsumerBuffer *buffer) {
+    free(buffer->buffer);
+    free(buffer->stamps);
+    free(buffer->seqs);
+    buffer->buffer = NULL;
+    buffer->stamps = NULL;
+    buffer->seqs = NULL;
+}
+
+void pc_buffer_default_options(PcBufferOptions *options) {
+    options->capacity = BUFFER_SIZE;
+    options->engine = PC_ENGINE_MUTEX;
+    options->semaphore = PC_SEM_POSIX;
+    options->sem_spin = 0;
+    options->overflow = PC_OVERFLOW_BLOCK;
+    options->rate_limit = 0.0;
+    options->rate_burst = 1;
+    options->quiet = false;
+}
+
 // Inicializar el buffer y semáforos
-int init_buffer(ProducerConsumerBuffer *buffer) {
-    if (!buffer) {
+int init_buffer(ProducerConsumerBuffer *buffer, int capacity) {
+    PcBufferOptions options;
+    pc_buffer_default_options(&options);
+    options.capacity = capacity;
+    return init_buffer_ex(buffer, &options);
+}
+
+int init_buffer_ex(ProducerConsumerBuffer *buffer, const PcBufferOptions *options) {
+    if (!buffer || !options) {
         fprintf(stderr, "Error: Buffer es NULL\n");
         return -1;
     }
 
+    int capacity = options->capacity;
+    if (capacity <= 0 || capacity > PC_MAX_CAPACITY) {
+        fprintf(stderr, "Error: capacidad inválida (%d)\n", capacity);
+        return -1;
+    }
+
+    if (options->engine != PC_ENGINE_MUTEX && options->engine != PC_ENGINE_TICKET) {
+        fprintf(stderr, "Error: motor inválido (%d)\n", options->engine);
+        return -1;
+    }
+
+    // Pisar items exige mover `out` bajo el mutex; el motor ticket no tiene
+    // cómo quitar una posición ya reservada por un consumidor
+    if (options->overflow < PC_OVERFLOW_BLOCK || options->overflow > PC_OVERFLOW_DROP_OLDEST ||
+        (options->overflow == PC_OVERFLOW_DROP_OLDEST && options->engine != PC_ENGINE_MUTEX)) {
+        fprintf(stderr, "Error: política de desborde inválida para el motor (%d)\n",
+                options->overflow);
+        return -1;
+    }
+
+    if (options->rate_limit < 0) {
+        fprintf(stderr, "Error: límite de tasa inválido (%g)\n", options->rate_limit);
+        return -1;
+    }
+
+    // Reservar almacenamiento
+    buffer->capacity = capacity;
+    buffer->engine = options->engine;
+    buffer->slots = round_up_pow2(capacity);
+    buffer->mask = buffer->slots - 1;
+    buffer->buffer = alloc_ring((size_t)buffer->slots * sizeof(int));
+    buffer->stamps = alloc_ring((size_t)buffer->slots * sizeof(long long));
+    buffer->seqs = NULL;
+    if (buffer->engine == PC_ENGINE_TICKET) {
+        buffer->seqs = alloc_ring((size_t)buffer->slots * sizeof(atomic_uint));
+    }
+    if (!buffer->buffer || !buffer->stamps ||
+        (buffer->engine == PC_ENGINE_TICKET && !buffer->seqs)) {
+        perror("Error reservando memoria del buffer");
+        free_storage(buffer);
+        return -1;
+    }
+
     // Inicializar índices
     buffer->in = 0;
     buffer->out = 0;
-    buffer->items_produced = 0;
-    buffer->items_consumed = 0;
-    buffer->shutdown = false;
+    atomic_init(&buffer->tail_ticket, 0);
+    atomic_init(&buffer->head_ticket, 0);
+    atomic_init(&buffer->producers_active, 0);
+    atomic_init(&buffer->items_produced, 0);
+    atomic_init(&buffer->items_consumed, 0);
+    atomic_init(&buffer->items_overwritten, 0);
+    atomic_init(&buffer->items_dropped, 0);
+    buffer->overflow = options->overflow;
+    buffer->rate_interval_ns = options->rate_limit > 0 ? (long long)(1e9 / options->rate_limit) : 0;
+    if (options->rate_limit > 0 && buffer->rate_interval_ns < 1) buffer->rate_interval_ns = 1;
+    buffer->rate_tolerance_ns =
+        (long long)(options->rate_burst > 1 ? options->rate_burst - 1 : 0) * buffer->rate_interval_ns;
+    atomic_init(&buffer->rate_tat, 0);
+    atomic_init(&buffer->rate_waits, 0);
+    atomic_init(&buffer->closed, false);
+    atomic_init(&buffer->shutdown, false);
+    buffer->latencies = NULL;
+    buffer->quiet = options->quiet;
 
     // Inicializar semáforos
-    if (sem_init(&buffer->empty, 0, BUFFER_SIZE) != 0) {
+    if (pc_sem_init(&buffer->empty, options->semaphore, capacity, options->sem_spin) != 0) {
         perror("Error inicializando semáforo empty");
+        free_storage(buffer);
         return -1;
     }
 
-    if (sem_init(&buffer->full, 0, 0) != 0) {
+    if (pc_sem_init(&buffer->full, options->semaphore, 0, options->sem_spin) != 0) {
         perror("Error inicializando semáforo full");
-        sem_destroy(&buffer->empty);
+        pc_sem_destroy(&buffer->empty);
+        free_storage(buffer);
         return -1;
     }
 
     // Inicializar mutex
     if (pthread_mutex_init(&buffer->mutex, NULL) != 0) {
         perror("Error inicializando mutex");
-        sem_destroy(&buffer->empty);
-        sem_destroy(&buffer->full);
+        pc_sem_destroy(&buffer->empty);
+        pc_sem_destroy(&buffer->full);
+        free_storage(buffer);
         return -1;
     }
 
-    // Inicializar buffer con valores -1 (vacío)
-    for (int i = 0; i < BUFFER_SIZE; i++) {
+    // Inicializar buffer con valores -1 (vacío); la posición i queda lista
+    // para el ticket i
+    for (int i = 0; i < buffer->slots; i++) {
         buffer->buffer[i] = -1;
+        if (buffer->seqs) {
+            atomic_init(&buffer->seqs[i], (unsigned)i);
+        }
     }
 
-    printf("Buffer inicializado correctamente (tamaño: %d)\n", BUFFER_SIZE);
+    if (!buffer->quiet) {
+        printf("Buffer inicializado correctamente (tamaño: %d%s%s%s)\n", capacity,
+               buffer->engine == PC_ENGINE_TICKET ? ", tickets" : "",
+               options->semaphore == PC_SEM_FUTEX ? ", futex" : "",
+               buffer->overflow == PC_OVERFLOW_DROP_NEWEST ? ", descarta nuevos"
+               : buffer->overflow == PC_OVERFLOW_DROP_OLDEST ? ", pisa viejos" : "");
+    }
     return 0;
 }
 
@@ -57,13 +180,320 @@ void destroy_buffer(ProducerConsumerBuffer *buffer) {
     buffer->shutdown = true;
     
     // Destruir semáforos
-    sem_destroy(&buffer->empty);
-    sem_destroy(&buffer->full);
+    pc_sem_destroy(&buffer->empty);
+    pc_sem_destroy(&buffer->full);
     
     // Destruir mutex
     pthread_mutex_destroy(&buffer->mutex);
     
-    printf("Buffer destruido correctamente\n");
+    // Liberar almacenamiento
+    free_storage(buffer);
+    
+    // Liberar histogramas de los consumidores
+    while (buffer->latencies) {
+        ConsumerLatency *next = buffer->latencies->next;
+        latency_histogram_free(buffer->latencies->queue_delay);
+        latency_histogram_free(buffer->latencies->end_to_end);
+        free(buffer->latencies);
+        buffer->latencies = next;
+    }
+    
+    if (!buffer->quiet) {
+        printf("Buffer destruido correctamente\n");
+    }
+}
+
+// Tomar hasta max unidades de un semáforo: espera por la primera y toma
+// sin bloquear las que ya estén disponibles. Devuelve cuántas tomó, 0 si
+// venció deadline_ns (< 0 = sin límite) o -1.
+static int claim_slots(PcSemaphore *sem, int max, long long deadline_ns, const char *name) {
+    while ((deadline_ns < 0 ? pc_sem_wait(sem) : pc_sem_timedwait(sem, deadline_ns)) != 0) {
+        if (errno == ETIMEDOUT) return 0;
+        if (errno != EINTR) {
+            fprintf(stderr, "Error en sem_wait(%s): %s\n", name, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 1 + pc_sem_try_wait_n(sem, max - 1);
+}
+
+// Esperar a que una posición llegue a la secuencia esperada (motor ticket).
+// El semáforo ya garantizó que la otra parte está en curso, así que la espera
+// es corta; en un solo CPU hay que ceder para que pueda terminar.
+static void wait_sequence(atomic_uint *seq, unsigned expected) {
+    for (int spins = 0; atomic_load_explicit(seq, memory_order_acquire) != expected; spins++) {
+        if (spins >= PC_SPIN_LIMIT) {
+            sched_yield();
+        }
+    }
+}
+
+// Cerrado o detenido: el límite de tasa deja de esperar
+static bool rate_limit_stopped(ProducerConsumerBuffer *buffer) {
+    return atomic_load(&buffer->closed) ||
+           atomic_load_explicit(&buffer->shutdown, memory_order_relaxed);
+}
+
+// Límite de tasa (token bucket en forma de GCRA): reservar count items sobre
+// rate_tat con una sola operación atómica y dormir lo que falte para que el
+// último de ellos esté dentro de la ráfaga permitida. Se llama una vez por
+// inserción con todos sus items, antes de reclamar slots: así no se duerme
+// reteniendo slots vacíos ni se cobra de nuevo lo que falta en cada ronda.
+// Duerme en tramos de PC_RATE_SLICE_US y mira el cierre entre uno y otro.
+// Devuelve -1 si el buffer está o queda cerrado (o detenido) antes de poder
+// insertar.
+static int rate_limit_wait(ProducerConsumerBuffer *buffer, int count) {
+    if (buffer->rate_interval_ns == 0 || count <= 0) return 0;
+    if (rate_limit_stopped(buffer)) return -1;
+
+    long long now = latency_now_ns();
+    long long cost = (long long)count * buffer->rate_interval_ns;
+    long long tat = atomic_load_explicit(&buffer->rate_tat, memory_order_relaxed);
+    long long start;
+    do {
+        start = tat > now ? tat : now;
+    } while (!atomic_compare_exchange_weak_explicit(&buffer->rate_tat, &tat, start + cost,
+                                                    memory_order_relaxed, memory_order_relaxed));
+
+    long long wait = start + cost - buffer->rate_interval_ns - buffer->rate_tolerance_ns - now;
+    if (wait <= 0) return 0;
+
+    atomic_fetch_add_explicit(&buffer->rate_waits, 1, memory_order_relaxed);
+    long long deadline = now + wait;
+    for (long long left = wait; left > 0; left = deadline - latency_now_ns()) {
+        long long us = (left + 999) / 1000;
+        usleep((useconds_t)(us < PC_RATE_SLICE_US ? us : PC_RATE_SLICE_US));
+        if (rate_limit_stopped(buffer)) return -1;
+    }
+    return 0;
+}
+
+// Reservar slots según la política de desborde: claimed son slots vacíos y
+// evicted permisos de `full` quitados a los consumidores, cuyos items se
+// pisan (PC_OVERFLOW_DROP_OLDEST). Devuelve claimed o -1.
+static int claim_for_put(ProducerConsumerBuffer *buffer, int count, int *evicted) {
+    *evicted = 0;
+    if (buffer->overflow == PC_OVERFLOW_BLOCK) {
+        return claim_slots(&buffer->empty, count, -1, "empty");
+    }
+
+    int claimed = pc_sem_try_wait_n(&buffer->empty, count);
+    if (buffer->overflow == PC_OVERFLOW_DROP_OLDEST && claimed < count) {
+        *evicted = pc_sem_try_wait_n(&buffer->full, count - claimed);
+        // Todos los items ya tienen consumidor: se liberan enseguida
+        if (claimed + *evicted == 0) {
+            claimed = claim_slots(&buffer->empty, count, -1, "empty");
+        }
+    }
+    return claimed;
+}
+
+// Insertar hasta count items con una sola sección crítica. Reclama los slots
+// vacíos que haya (al menos uno, salvo que la política descarte) y los
+// publica juntos; devuelve cuántos items insertó y en first_slot la posición
+// del primero, o -1 si está cerrado. En dropped quedan los items del final
+// que se descartaron (PC_OVERFLOW_DROP_NEWEST).
+static int put_items(ProducerConsumerBuffer *buffer, const int *items, int count,
+                     long long stamp, int *first_slot, int *dropped) {
+    *dropped = 0;
+
+    // Anunciarse antes de mirar closed: buffer_close ve a este productor o
+    // este productor ve el cierre (ambos seq_cst)
+    atomic_fetch_add(&buffer->producers_active, 1);
+    if (atomic_load(&buffer->closed)) {
+        atomic_fetch_sub(&buffer->producers_active, 1);
+        return -1;
+    }
+
+    int evicted;
+    int claimed = claim_for_put(buffer, count, &evicted);
+    if (claimed < 0 || atomic_load_explicit(&buffer->shutdown, memory_order_relaxed)) {
+        // Devolver los permisos: con shutdown despiertan al siguiente en cascada
+        if (claimed > 0) pc_sem_post_n(&buffer->empty, claimed);
+        pc_sem_post_n(&buffer->full, evicted);
+        atomic_fetch_sub(&buffer->producers_active, 1);
+        return -1;
+    }
+
+    if (buffer->overflow == PC_OVERFLOW_DROP_NEWEST && claimed < count) {
+        *dropped = count - claimed;
+        atomic_fetch_add_explicit(&buffer->items_dropped, *dropped, memory_order_relaxed);
+    }
+
+    int extra = 0;   // Permisos de full sin item (el de cierre), a devolver
+    if (claimed == 0 && evicted == 0) {
+        *first_slot = -1;
+    } else if (buffer->engine == PC_ENGINE_TICKET) {
+        // Tomar `claimed` posiciones consecutivas sin competir con los consumidores
+        unsigned ticket = atomic_fetch_add_explicit(&buffer->tail_ticket, (unsigned)claimed,
+                                                    memory_order_relaxed);
+        *first_slot = (int)(ticket & (unsigned)buffer->mask);
+        for (int i = 0; i < claimed; i++, ticket++) {
+            int idx = (int)(ticket & (unsigned)buffer->mask);
+            // La posición puede estar siendo leída aún por el consumidor de la vuelta anterior
+            wait_sequence(&buffer->seqs[idx], ticket);
+            buffer->buffer[idx] = items[i];
+            buffer->stamps[idx] = stamp;
+            atomic_store_explicit(&buffer->seqs[idx], ticket + 1, memory_order_release);
+        }
+        atomic_fetch_add(&buffer->items_produced, claimed);
+    } else {
+        // Sección crítica: sólo el movimiento de datos, sin E/S
+        pthread_mutex_lock(&buffer->mutex);
+        if (evicted > 0) {
+            // Pisar los más viejos: avanzar `out` y reutilizar sus slots
+            int pending = buffer->items_produced - buffer->items_consumed -
+                          buffer->items_overwritten;
+            int overwritten = evicted < pending ? evicted : pending;
+            buffer->out = (buffer->out + overwritten) & buffer->mask;
+            atomic_fetch_add(&buffer->items_overwritten, overwritten);
+            extra = evicted - overwritten;
+            claimed += overwritten;
+        }
+        *first_slot = buffer->in;
+        for (int i = 0; i < claimed; i++) {
+            buffer->buffer[buffer->in] = items[i];
+            buffer->stamps[buffer->in] = stamp;
+            buffer->in = (buffer->in + 1) & buffer->mask;
+        }
+        atomic_fetch_add(&buffer->items_produced, claimed);
+        pthread_mutex_unlock(&buffer->mutex);
+    }
+    atomic_fetch_sub(&buffer->producers_active, 1);
+
+    // Señalar los items disponibles
+    pc_sem_post_n(&buffer->full, claimed + extra);
+    return claimed;
+}
+
+// Cerrado y sin nada más por venir: ningún productor en curso y todos los
+// items producidos ya reservados por algún consumidor. Se lee primero
+// producers_active porque cada productor suma items_produced antes de salir.
+static bool drained(ProducerConsumerBuffer *buffer) {
+    if (!atomic_load(&buffer->closed) || atomic_load(&buffer->producers_active) > 0) {
+        return false;
+    }
+
+    unsigned produced = (unsigned)atomic_load(&buffer->items_produced);
+    unsigned reserved = buffer->engine == PC_ENGINE_TICKET
+                            ? atomic_load(&buffer->head_ticket)
+                            : (unsigned)(atomic_load(&buffer->items_consumed) +
+                                         atomic_load(&buffer->items_overwritten));
+    return produced == reserved;
+}
+
+// Extraer hasta max items con una sola sección crítica (espera por el
+// primero, hasta deadline_ns si no es negativo); devuelve cuántos extrajo y
+// en first_slot la posición del primero, 0 si venció el plazo, o -1 al
+// cerrar. stamps puede ser NULL.
+//
+// Cada permiso de full corresponde a un item producido, salvo el permiso de
+// cierre: por eso se reservan como mucho los items que existen, y los
+// permisos sobrantes se devuelven para que lleguen al siguiente consumidor.
+static int get_items(ProducerConsumerBuffer *buffer, int *items, long long *stamps, int max,
+                     long long deadline_ns, int *first_slot) {
+    for (;;) {
+        int claimed = claim_slots(&buffer->full, max, deadline_ns, "full");
+        if (claimed <= 0) return claimed < 0 ? -1 : 0;
+
+        // Verificar si debemos terminar
+        if (atomic_load_explicit(&buffer->shutdown, memory_order_relaxed)) {
+            pc_sem_post_n(&buffer->full, claimed);
+            return -1;
+        }
+
+        int taken;
+        if (buffer->engine == PC_ENGINE_TICKET) {
+            // Reservar tickets de items ya contados por su productor; el
+            // productor del primero puede estar terminando de escribirlo y la
+            // secuencia indica cuándo está completo
+            unsigned ticket = atomic_load_explicit(&buffer->head_ticket, memory_order_relaxed);
+            do {
+                int available = (int)((unsigned)atomic_load(&buffer->items_produced) - ticket);
+                taken = claimed < available ? claimed : available;
+            } while (taken > 0 &&
+                     !atomic_compare_exchange_weak_explicit(&buffer->head_ticket, &ticket,
+                                                            ticket + (unsigned)taken,
+                                                            memory_order_relaxed,
+                                                            memory_order_relaxed));
+
+            *first_slot = (int)(ticket & (unsigned)buffer->mask);
+            for (int i = 0; i < taken; i++, ticket++) {
+                int idx = (int)(ticket & (unsigned)buffer->mask);
+                wait_sequence(&buffer->seqs[idx], ticket + 1);
+                items[i] = buffer->buffer[idx];
+                if (stamps) stamps[i] = buffer->stamps[idx];
+                buffer->buffer[idx] = -1; // Marcar como vacío
+                // Liberar la posición para la siguiente vuelta
+                atomic_store_explicit(&buffer->seqs[idx], ticket + (unsigned)buffer->slots,
+                                      memory_order_release);
+            }
+            atomic_fetch_add(&buffer->items_consumed, taken);
+        } else {
+            pthread_mutex_lock(&buffer->mutex);
+
+            // Verificar si realmente hay items (double-check)
+            int available = buffer->items_produced - buffer->items_consumed -
+                            buffer->items_overwritten;
+            taken = claimed < available ? claimed : available;
+
+            *first_slot = buffer->out;
+            for (int i = 0; i < taken; i++) {
+                items[i] = buffer->buffer[buffer->out];
+                if (stamps) stamps[i] = buffer->stamps[buffer->out];
+                buffer->buffer[buffer->out] = -1; // Marcar como vacío
+                buffer->out = (buffer->out + 1) & buffer->mask;
+            }
+            atomic_fetch_add(&buffer->items_consumed, taken);
+            pthread_mutex_unlock(&buffer->mutex);
+        }
+
+        // Permisos sin item (el de cierre): pasarlos al siguiente consumidor
+        pc_sem_post_n(&buffer->full, claimed - taken);
+
+        if (taken > 0) {
+            // Señalar los slots libres
+            pc_sem_post_n(&buffer->empty, taken);
+            return taken;
+        }
+
+        // Sólo se llega aquí con el buffer cerrado. Si aún hay productores
+        // terminando de insertar se vuelve a esperar; si no, se sale.
+        if (drained(buffer)) return -1;
+        sched_yield();
+    }
+}
+
+void buffer_close(ProducerConsumerBuffer *buffer) {
+    if (!buffer) return;
+
+    // Sólo el primer cierre agrega el permiso que recorre a los consumidores
+    if (!atomic_exchange(&buffer->closed, true)) {
+        pc_sem_post(&buffer->full);
+    }
+}
+
+void buffer_shutdown(ProducerConsumerBuffer *buffer) {
+    if (!buffer) return;
+
+    if (!atomic_exchange(&buffer->shutdown, true)) {
+        pc_sem_post(&buffer->full);
+        pc_sem_post(&buffer->empty);
+    }
+}
+
+const PcLoadProfile pc_demo_load = {100000, 200000, 150000, 250000, 50000};
+const PcLoadProfile pc_no_load = {0, 0, 0, 0, 0};
+
+// Flujos del PRNG por hilo: misma semilla maestra, mismas pausas por hilo
+#define PC_PRNG_PRODUCER 1
+#define PC_PRNG_CONSUMER 2
+
+// Pausa de la carga simulada; sin carga no hay syscall
+static void load_pause(int min_us, int jitter_us) {
+    if (min_us <= 0 && jitter_us <= 0) return;
+    usleep(min_us + (jitter_us > 0 ? (int)prng_thread_below((uint32_t)jitter_us) : 0));
 }
 
 // Función del productor
@@ -72,47 +502,63 @@ void *producer(void *arg) {
     ProducerConsumerBuffer *buffer = data->buffer;
     int thread_id = data->thread_id;
     int items_to_produce = data->items_to_produce;
+    int batch_size = data->batch_size > 1 ? data->batch_size : 1;
+    if (batch_size > PC_MAX_BATCH) batch_size = PC_MAX_BATCH;
+    const PcLoadProfile *load = data->load ? data->load : &pc_demo_load;
+    prng_thread_seed(PRNG_STREAM(PC_PRNG_PRODUCER, thread_id));
 
-    printf("Productor %d iniciado (producirá %d items)\n", thread_id, items_to_produce);
+    TRACE(TRACE_INFO, TRACE_PRODUCER_START, thread_id, items_to_produce, -1);
 
-    for (int i = 0; i < items_to_produce && !buffer->shutdown; i++) {
-        // Producir item
-        int item = produce_item(thread_id, i);
-        
-        // Esperar por slot vacío
-        if (sem_wait(&buffer->empty) != 0) {
-            perror("Error en sem_wait(empty)");
-            break;
+    int items[PC_MAX_BATCH];
+    bool exhausted = false;
+    for (int i = 0; !exhausted && (items_to_produce < 0 || i < items_to_produce); ) {
+        // Producir una ráfaga (la latencia se mide desde aquí)
+        int burst = batch_size;
+        if (items_to_produce >= 0 && items_to_produce - i < burst) {
+            burst = items_to_produce - i;
         }
-
-        // Verificar si debemos terminar
-        if (buffer->shutdown) {
-            sem_post(&buffer->empty);
-            break;
+        int made = 0;
+        while (made < burst) {
+            if (data->produce) {
+                if (data->produce(data->ctx, thread_id, i + made, &items[made]) != 0) {
+                    exhausted = true;
+                    break;
+                }
+            } else {
+                items[made] = produce_item(thread_id, i + made);
+            }
+            made++;
         }
-
-        // Entrar en sección crítica
-        pthread_mutex_lock(&buffer->mutex);
-        
-        // Agregar item al buffer
-        buffer->buffer[buffer->in] = item;
-        printf("Productor %d: item %d agregado en posición %d\n", 
-               thread_id, item, buffer->in);
-        
-        buffer->in = (buffer->in + 1) % BUFFER_SIZE;
-        buffer->items_produced++;
-        
-        // Salir de sección crítica
-        pthread_mutex_unlock(&buffer->mutex);
+        // La espera del límite de tasa no cuenta como demora en la cola
+        if (rate_limit_wait(buffer, made) != 0) break;
+        long long stamp = latency_now_ns();
         
-        // Señalar que hay un item disponible
-        sem_post(&buffer->full);
+        // Publicar la ráfaga; puede requerir varias rondas si hay pocos slots
+        for (int done = 0; done < made; ) {
+            int slot, dropped;
+            int put = put_items(buffer, items + done, made - done, stamp, &slot, &dropped);
+            if (put < 0) {
+                TRACE(TRACE_INFO, TRACE_PRODUCER_END, thread_id, 0, -1);
+                return NULL;
+            }
+            
+            // La traza se registra fuera de la sección crítica, fechada al
+            // producir para que quede antes de la extracción del consumidor
+            for (int j = 0; j < put; j++) {
+                TRACE_AT(TRACE_DEBUG, TRACE_ITEM_PUT, stamp, thread_id, items[done + j],
+                         (slot + j) & buffer->mask);
+            }
+            done += put + dropped;
+        }
+        i += made;
         
         // Simular tiempo de producción
-        usleep(100000 + (rand() % 200000)); // 0.1-0.3 segundos
+        if (!exhausted) {
+            load_pause(load->produce_min_us, load->produce_jitter_us);
+        }
     }
 
-    printf("Productor %d terminado\n", thread_id);
+    TRACE(TRACE_INFO, TRACE_PRODUCER_END, thread_id, 0, -1);
     return NULL;
 }
 
@@ -121,59 +567,161 @@ void *consumer(void *arg) {
     ThreadData *data = (ThreadData *)arg;
     ProducerConsumerBuffer *buffer = data->buffer;
     int thread_id = data->thread_id;
+    int batch_size = data->batch_size > 1 ? data->batch_size : 1;
+    if (batch_size > PC_MAX_BATCH) batch_size = PC_MAX_BATCH;
+    const PcLoadProfile *load = data->load ? data->load : &pc_demo_load;
+    prng_thread_seed(PRNG_STREAM(PC_PRNG_CONSUMER, thread_id));
 
-    printf("Consumidor %d iniciado\n", thread_id);
+    TRACE(TRACE_INFO, TRACE_CONSUMER_START, thread_id, 0, -1);
 
-    while (!buffer->shutdown) {
-        // Esperar por item disponible
-        if (sem_wait(&buffer->full) != 0) {
-            if (errno == EINTR) continue;
-            perror("Error en sem_wait(full)");
-            break;
-        }
+    // Histogramas propios; si no hay memoria se sigue sin medir
+    ConsumerLatency *latency = register_consumer_latency(buffer);
 
-        // Verificar si debemos terminar
-        if (buffer->shutdown) {
-            sem_post(&buffer->full);
+    int items[PC_MAX_BATCH];
+    long long stamps[PC_MAX_BATCH];
+    for (;;) {
+        int slot;
+        int taken = get_items(buffer, items, stamps, batch_size, -1, &slot);
+        if (taken < 0) {
             break;
         }
-
-        // Entrar en sección crítica
-        pthread_mutex_lock(&buffer->mutex);
         
-        // Verificar si realmente hay items (double-check)
-        if (buffer->items_produced == buffer->items_consumed) {
-            pthread_mutex_unlock(&buffer->mutex);
-            sem_post(&buffer->full);
-            continue;
+        for (int j = 0; j < taken; j++) {
+            TRACE(TRACE_DEBUG, TRACE_ITEM_GET, thread_id, items[j], (slot + j) & buffer->mask);
         }
         
-        // Extraer item del buffer
-        int item = buffer->buffer[buffer->out];
-        buffer->buffer[buffer->out] = -1; // Marcar como vacío
-        printf("Consumidor %d: item %d extraído de posición %d\n", 
-               thread_id, item, buffer->out);
-        
-        buffer->out = (buffer->out + 1) % BUFFER_SIZE;
-        buffer->items_consumed++;
-        
-        // Salir de sección crítica
-        pthread_mutex_unlock(&buffer->mutex);
-        
-        // Señalar que hay un slot libre
-        sem_post(&buffer->empty);
-        
-        // Consumir item
-        consume_item(item, thread_id);
+        for (int j = 0; j < taken; j++) {
+            if (latency) {
+                latency_histogram_record(latency->queue_delay, latency_now_ns() - stamps[j]);
+            }
+            
+            // Consumir item
+            if (data->consume) {
+                data->consume(data->ctx, thread_id, items[j]);
+            } else {
+                consume_item(items[j], thread_id);
+            }
+            load_pause(load->work_us, 0);
+            
+            if (latency) {
+                latency_histogram_record(latency->end_to_end, latency_now_ns() - stamps[j]);
+            }
+        }
         
         // Simular tiempo de consumo
-        usleep(150000 + (rand() % 250000)); // 0.15-0.4 segundos
+        load_pause(load->consume_min_us, load->consume_jitter_us);
     }
 
-    printf("Consumidor %d terminado\n", thread_id);
+    TRACE(TRACE_INFO, TRACE_CONSUMER_END, thread_id, 0, -1);
     return NULL;
 }
 
+// Insertar un item esperando por un slot vacío
+int buffer_put(ProducerConsumerBuffer *buffer, int item) {
+    if (!buffer) return -1;
+
+    // Fechar después del límite de tasa, como producer()
+    if (rate_limit_wait(buffer, 1) != 0) return -1;
+
+    int slot, dropped;
+    return put_items(buffer, &item, 1, latency_now_ns(), &slot, &dropped) < 0 ? -1 : 0;
+}
+
+int buffer_put_stamped(ProducerConsumerBuffer *buffer, int item, long long stamp) {
+    if (!buffer) return -1;
+
+    if (rate_limit_wait(buffer, 1) != 0) return -1;
+
+    int slot, dropped;
+    return put_items(buffer, &item, 1, stamp, &slot, &dropped) < 0 ? -1 : 0;
+}
+
+// Extraer un item esperando a que haya uno disponible
+int buffer_get(ProducerConsumerBuffer *buffer, int *item) {
+    long long stamp;
+    return buffer_get_stamped(buffer, item, &stamp);
+}
+
+int buffer_get_stamped(ProducerConsumerBuffer *buffer, int *item, long long *stamp) {
+    if (!buffer || !item || !stamp) return -1;
+
+    int slot;
+    return get_items(buffer, item, stamp, 1, -1, &slot) == 1 ? 0 : -1;
+}
+
+// Insertar count items; cada ronda reclama todos los slots libres de una vez
+int buffer_put_batch(ProducerConsumerBuffer *buffer, const int *items, int count) {
+    if (!buffer || !items || count < 0) return -1;
+
+    if (rate_limit_wait(buffer, count) != 0) return -1;
+    long long stamp = latency_now_ns();
+
+    for (int done = 0; done < count; ) {
+        int slot, dropped;
+        int put = put_items(buffer, items + done, count - done, stamp, &slot, &dropped);
+        if (put < 0) return -1;
+        done += put + dropped;
+    }
+    return 0;
+}
+
+// Extraer entre 1 y max_items items
+int buffer_get_batch(ProducerConsumerBuffer *buffer, int *items, long long *stamps,
+                     int max_items) {
+    if (!buffer || !items || max_items <= 0) return -1;
+
+    int slot;
+    return get_items(buffer, items, stamps, max_items, -1, &slot);
+}
+
+// Como buffer_get_batch, pero si en timeout_ms no llega ningún item devuelve 0
+int buffer_get_timed(ProducerConsumerBuffer *buffer, int *items, long long *stamps,
+                     int max_items, int timeout_ms) {
+    if (!buffer || !items || max_items <= 0) return -1;
+
+    long long deadline = latency_now_ns() + (long long)(timeout_ms > 0 ? timeout_ms : 0) * 1000000LL;
+    int slot;
+    return get_items(buffer, items, stamps, max_items, deadline, &slot);
+}
+
+// Crear los histogramas de un consumidor y enlazarlos en el buffer
+ConsumerLatency *register_consumer_latency(ProducerConsumerBuffer *buffer) {
+    if (!buffer) return NULL;
+
+    ConsumerLatency *latency = malloc(sizeof(ConsumerLatency));
+    if (!latency) return NULL;
+
+    latency->queue_delay = latency_histogram_create();
+    latency->end_to_end = latency_histogram_create();
+    if (!latency->queue_delay || !latency->end_to_end) {
+        latency_histogram_free(latency->queue_delay);
+        latency_histogram_free(latency->end_to_end);
+        free(latency);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&buffer->mutex);
+    latency->next = buffer->latencies;
+    buffer->latencies = latency;
+    pthread_mutex_unlock(&buffer->mutex);
+
+    return latency;
+}
+
+// Combinar los histogramas de todos los consumidores
+void buffer_latency_snapshot(ProducerConsumerBuffer *buffer,
+                             LatencyHistogram *queue_delay, LatencyHistogram *end_to_end) {
+    latency_histogram_reset(queue_delay);
+    latency_histogram_reset(end_to_end);
+
+    pthread_mutex_lock(&buffer->mutex);
+    for (ConsumerLatency *l = buffer->latencies; l; l = l->next) {
+        latency_histogram_merge(queue_delay, l->queue_delay);
+        latency_histogram_merge(end_to_end, l->end_to_end);
+    }
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
 // Función para producir un item
 int produce_item(int thread_id, int item_number) {
     // Generar un item único basado en el thread_id y número de item
@@ -182,10 +730,9 @@ int produce_item(int thread_id, int item_number) {
 }
 
 // Función para consumir un item
+// (el tiempo de procesamiento simulado lo agrega la carga, work_us)
 void consume_item(int item, int thread_id) {
-    printf("Consumidor %d procesando item %d\n", thread_id, item);
-    // Simular procesamiento del item
-    usleep(50000); // 0.05 segundos
+    TRACE(TRACE_DEBUG, TRACE_ITEM_CONSUMED, thread_id, item, -1);
 }
 
 // Funciones auxiliares
@@ -193,17 +740,25 @@ void print_buffer_status(ProducerConsumerBuffer *buffer) {
     pthread_mutex_lock(&buffer->mutex);
     
     printf("\n=== Estado del Buffer ===\n");
+    // Con buffers grandes sólo se muestran las primeras posiciones
+    int shown = buffer->slots < 32 ? buffer->slots : 32;
     printf("Buffer: [");
-    for (int i = 0; i < BUFFER_SIZE; i++) {
+    for (int i = 0; i < shown; i++) {
         if (buffer->buffer[i] == -1) {
             printf(" _ ");
         } else {
             printf("%3d", buffer->buffer[i]);
         }
-        if (i < BUFFER_SIZE - 1) printf(",");
+        if (i < shown - 1) printf(",");
+    }
+    printf("%s]\n", shown < buffer->slots ? ", ..." : "");
+    if (buffer->engine == PC_ENGINE_TICKET) {
+        printf("In: %u, Out: %u (tickets)\n",
+               atomic_load(&buffer->tail_ticket) & (unsigned)buffer->mask,
+               atomic_load(&buffer->head_ticket) & (unsigned)buffer->mask);
+    } else {
+        printf("In: %d, Out: %d\n", buffer->in, buffer->out);
     }
-    printf("]\n");
-    printf("In: %d, Out: %d\n", buffer->in, buffer->out);
     printf("Producidos: %d, Consumidos: %d\n", 
            buffer->items_produced, buffer->items_consumed);
     
@@ -211,20 +766,48 @@ void print_buffer_status(ProducerConsumerBuffer *buffer) {
 }
 
 void print_statistics(ProducerConsumerBuffer *buffer) {
+    // Sacar las trazas pendientes para que no se intercalen con el resumen
+    trace_flush();
+    
     pthread_mutex_lock(&buffer->mutex);
     
     printf("\n=== Estadísticas Finales ===\n");
     printf("Total items producidos: %d\n", buffer->items_produced);
     printf("Total items consumidos: %d\n", buffer->items_consumed);
-    printf("Items pendientes: %d\n", buffer->items_produced - buffer->items_consumed);
+    printf("Items pendientes: %d\n", buffer_pending(buffer));
+    if (buffer->items_dropped > 0 || buffer->items_overwritten > 0) {
+        printf("Items descartados: %lld rechazados, %d pisados\n",
+               (long long)buffer->items_dropped, buffer->items_overwritten);
+    }
+    if (buffer->rate_waits > 0) {
+        printf("Inserciones demoradas por límite de tasa: %lld\n", (long long)buffer->rate_waits);
+    }
     
     pthread_mutex_unlock(&buffer->mutex);
+    
+    // Latencias combinadas de todos los consumidores
+    LatencyHistogram *queue_delay = latency_histogram_create();
+    LatencyHistogram *end_to_end = latency_histogram_create();
+    if (queue_delay && end_to_end) {
+        buffer_latency_snapshot(buffer, queue_delay, end_to_end);
+        latency_histogram_print(queue_delay, "Latencia en buffer");
+        latency_histogram_print(end_to_end, "Latencia extremo a extremo");
+    }
+    latency_histogram_free(queue_delay);
+    latency_histogram_free(end_to_end);
 }
 
+// in == out no distingue lleno de vacío cuando capacity == slots, así que
+// se usan los contadores
 bool is_buffer_full(ProducerConsumerBuffer *buffer) {
-    return ((buffer->in + 1) % BUFFER_SIZE) == buffer->out;
+    return buffer_pending(buffer) == buffer->capacity;
 }
 
 bool is_buffer_empty(ProducerConsumerBuffer *buffer) {
-    return buffer->in == buffer->out;
+    return buffer_pending(buffer) == 0;
+}
+
+int buffer_pending(ProducerConsumerBuffer *buffer) {
+    return atomic_load(&buffer->items_produced) - atomic_load(&buffer->items_consumed) -
+           atomic_load(&buffer->items_overwritten);
 }
\ No newline at end of file
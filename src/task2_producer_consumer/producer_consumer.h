@@ -2,37 +2,194 @@
 #define PRODUCER_CONSUMER_H
 
 #include <pthread.h>
-#include <semaphore.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include "latency_histogram.h"
+#include "pc_semaphore.h"
+#include "trace.h"
 
-#define BUFFER_SIZE 10
+#define BUFFER_SIZE 10              // Capacidad por defecto
 #define MAX_ITEMS 100
+#define PC_MAX_CAPACITY (1 << 24)
+#define PC_CACHE_LINE 64
+#define PC_MAX_BATCH 64             // Máximo de items por ráfaga en producer()/consumer()
+#define PC_HUGEPAGE_BYTES (2 * 1024 * 1024) // Arreglos de este tamaño o más piden huge pages
+#define PC_SPIN_LIMIT 64            // Vueltas antes de ceder el CPU esperando un slot (motor ticket)
+#define PC_RATE_SLICE_US 1000      // Tramo máximo de sueño del límite de tasa entre chequeos de cierre
+
+// Motor del buffer: cómo se reparten las posiciones una vez que el semáforo
+// concedió el permiso
+typedef enum {
+    PC_ENGINE_MUTEX,            // in/out protegidos por un mutex común
+    PC_ENGINE_TICKET            // Tickets atómicos separados para productores y consumidores
+} PcEngine;
+
+// Qué hace una inserción con el buffer lleno. Las políticas que descartan
+// evitan que la demora en cola crezca cuando los consumidores se atrasan.
+typedef enum {
+    PC_OVERFLOW_BLOCK,          // Esperar un slot libre (comportamiento clásico)
+    PC_OVERFLOW_DROP_NEWEST,    // Descartar los items que no entran
+    PC_OVERFLOW_DROP_OLDEST     // Pisar los más viejos aún no tomados (sólo motor mutex)
+} PcOverflowPolicy;
+
+// Opciones de init_buffer_ex; pc_buffer_default_options() las llena con los
+// valores por defecto
+typedef struct {
+    int capacity;
+    PcEngine engine;
+    PcSemKind semaphore;        // sem_t de POSIX o futex
+    int sem_spin;               // Vueltas antes de dormir (sólo futex)
+    PcOverflowPolicy overflow;
+    double rate_limit;          // Items/s admitidos entre todos los productores (0 = sin límite)
+    int rate_burst;             // Ráfaga admitida sin esperar (token bucket; mínimo 1)
+    bool quiet;                 // Sin mensajes al inicializar y destruir (benchmarks)
+} PcBufferOptions;
+
+// Histogramas de latencia de un consumidor (se registra sin locks; el buffer
+// sólo guarda la lista para combinarlos en print_statistics)
+typedef struct ConsumerLatency {
+    LatencyHistogram *queue_delay;   // Desde produce_item hasta salir del buffer
+    LatencyHistogram *end_to_end;    // Desde produce_item hasta terminar consume_item
+    struct ConsumerLatency *next;
+} ConsumerLatency;
 
 // Estructura del buffer compartido
+// El almacenamiento tiene `slots` posiciones (potencia de 2 >= capacity) para
+// que el avance de los índices sea una máscara; el semáforo empty limita a
+// `capacity` los items en vuelo, así que la profundidad pedida se respeta.
+//
+// Con PC_ENGINE_TICKET los productores toman posiciones con fetch-add sobre
+// tail_ticket y los consumidores sobre head_ticket, cada uno en su línea de
+// caché: productores y consumidores no comparten ningún lock. Cada posición
+// lleva un número de secuencia que indica de qué vuelta es el dato, así un
+// consumidor nunca lee una posición que su productor todavía está
+// escribiendo. Los semáforos quedan sólo para bloquear.
 typedef struct {
-    int buffer[BUFFER_SIZE];
-    int in;                     // Índice para insertar
-    int out;                    // Índice para extraer
-    sem_t empty;               // Semáforo para slots vacíos
-    sem_t full;                // Semáforo para slots llenos
-    pthread_mutex_t mutex;     // Mutex para acceso exclusivo al buffer
-    int items_produced;        // Contador de items producidos
-    int items_consumed;        // Contador de items consumidos
-    bool shutdown;             // Flag para terminar la ejecución
+    int *buffer;                // Items (heap, alineado a línea de caché)
+    long long *stamps;          // Momento de producción de cada item (ns, CLOCK_MONOTONIC)
+    int capacity;               // Máximo de items en el buffer
+    int slots;                  // Posiciones del arreglo (potencia de 2)
+    int mask;                   // slots - 1
+    PcEngine engine;
+    int in;                     // Índice para insertar (motor mutex)
+    int out;                    // Índice para extraer (motor mutex)
+    atomic_uint *seqs;          // Secuencia de cada posición (motor ticket)
+    _Alignas(PC_CACHE_LINE) atomic_uint tail_ticket;  // Próxima posición a escribir
+    atomic_int producers_active; // Productores dentro de una inserción (ver buffer_close)
+    _Alignas(PC_CACHE_LINE) atomic_uint head_ticket;  // Próxima posición a leer
+    _Alignas(PC_CACHE_LINE) PcSemaphore empty;  // Semáforo para slots vacíos
+    PcSemaphore full;          // Semáforo para slots llenos
+    pthread_mutex_t mutex;     // Mutex para acceso exclusivo al buffer (motor mutex)
+    atomic_int items_produced; // Contador de items producidos
+    atomic_int items_consumed; // Contador de items consumidos
+    atomic_int items_overwritten; // Insertados y luego pisados (PC_OVERFLOW_DROP_OLDEST)
+    atomic_llong items_dropped; // Rechazados sin entrar (PC_OVERFLOW_DROP_NEWEST)
+    PcOverflowPolicy overflow;
+    // Token bucket como GCRA: rate_tat es el instante (ns) en que el bucket
+    // vuelve a estar lleno; cada item lo corre rate_interval_ns
+    long long rate_interval_ns; // 0 = sin límite
+    long long rate_tolerance_ns; // (rate_burst - 1) * rate_interval_ns
+    atomic_llong rate_tat;
+    atomic_llong rate_waits;   // Inserciones demoradas por el límite de tasa
+    atomic_bool closed;        // No se aceptan más items; los consumidores vacían y salen
+    atomic_bool shutdown;      // Terminar ya, aunque queden items
+    ConsumerLatency *latencies; // Histogramas registrados por los consumidores (protegido por mutex)
+    bool quiet;                // Ver PcBufferOptions
 } ProducerConsumerBuffer;
 
+// Trabajo de los hilos, con un puntero de contexto del usuario.
+// produce genera el item número `index` del hilo en *item y devuelve 0, o
+// distinto de 0 si ya no hay más (el productor termina). consume procesa un
+// item extraído. Si no se registran se usan produce_item/consume_item.
+typedef int (*PcProduceFn)(void *ctx, int thread_id, int index, int *item);
+typedef void (*PcConsumeFn)(void *ctx, int thread_id, int item);
+
+// Carga simulada para demostraciones: pausas de min_us + [0, jitter_us) µs
+// después de cada ráfaga producida y de cada ráfaga consumida, y work_us por
+// item consumido. Con todo en 0 no se llama a usleep.
+typedef struct {
+    int produce_min_us;
+    int produce_jitter_us;
+    int consume_min_us;
+    int consume_jitter_us;
+    int work_us;
+} PcLoadProfile;
+
+extern const PcLoadProfile pc_demo_load;   // Los tiempos originales del laboratorio
+extern const PcLoadProfile pc_no_load;     // Sin pausas
+
 // Estructura para pasar datos a los threads
 typedef struct {
     ProducerConsumerBuffer *buffer;
     int thread_id;
-    int items_to_produce;
+    int items_to_produce;       // Productores: máximo de items (< 0 = hasta que produce diga basta)
+    int batch_size;             // Items por ráfaga (0 o 1 = de a uno, máximo PC_MAX_BATCH)
+    PcProduceFn produce;        // NULL = produce_item
+    PcConsumeFn consume;        // NULL = consume_item
+    void *ctx;                  // Contexto para produce/consume
+    const PcLoadProfile *load;  // NULL = pc_demo_load
 } ThreadData;
 
 // Funciones principales
-int init_buffer(ProducerConsumerBuffer *buffer);
+// init_buffer usa el motor mutex con sem_t; init_buffer_ex permite elegir
+// el motor y el semáforo
+int init_buffer(ProducerConsumerBuffer *buffer, int capacity);
+int init_buffer_ex(ProducerConsumerBuffer *buffer, const PcBufferOptions *options);
+void pc_buffer_default_options(PcBufferOptions *options);
 void destroy_buffer(ProducerConsumerBuffer *buffer);
 void *producer(void *arg);
 void *consumer(void *arg);
+
+// Cierre ordenado: desde aquí las inserciones nuevas fallan, las que ya
+// estaban en curso se completan, y los consumidores extraen todo lo que quede
+// y luego reciben -1. Un único permiso extra en `full` despierta a un
+// consumidor bloqueado, que al salir lo devuelve para el siguiente, así que
+// todos salen apenas se consume el último item, sin esperas ni sondeos.
+// Se puede llamar más de una vez.
+void buffer_close(ProducerConsumerBuffer *buffer);
+
+// Parada inmediata (p. ej. desde un manejador de señales): productores y
+// consumidores salen en su próxima operación aunque queden items
+void buffer_shutdown(ProducerConsumerBuffer *buffer);
+
+// Operaciones básicas sobre el buffer (sin retardos ni mensajes), usadas por
+// los benchmarks. Bloquean mientras el buffer está lleno/vacío y devuelven
+// 0 si la operación se realizó, -1 si el buffer está cerrado (y, al extraer,
+// ya vacío), se detuvo con buffer_shutdown o hay error. Con una política
+// que descarta, insertar devuelve 0 aunque el item se haya descartado (se
+// cuenta en items_dropped o items_overwritten); con límite de tasa, insertar
+// puede esperar a que haya tokens.
+int buffer_put(ProducerConsumerBuffer *buffer, int item);
+int buffer_get(ProducerConsumerBuffer *buffer, int *item);
+
+// Variantes que transportan el momento de producción del item (ns, de
+// latency_now_ns()); buffer_put usa el instante de la inserción
+int buffer_put_stamped(ProducerConsumerBuffer *buffer, int item, long long stamp);
+int buffer_get_stamped(ProducerConsumerBuffer *buffer, int *item, long long *stamp);
+
+// Variantes por lotes: amortizan semáforos y mutex entre varios items.
+// put_batch inserta los count items (reclamando en cada ronda todos los slots
+// libres y publicándolos juntos) y devuelve 0 o -1. get_batch espera por el
+// primer item, extrae además los que ya estén disponibles hasta max_items y
+// devuelve cuántos extrajo, o -1. stamps puede ser NULL.
+int buffer_put_batch(ProducerConsumerBuffer *buffer, const int *items, int count);
+int buffer_get_batch(ProducerConsumerBuffer *buffer, int *items, long long *stamps,
+                     int max_items);
+
+// get_batch con espera acotada: devuelve 0 si en timeout_ms no llegó ningún
+// item (p. ej. para que un consumidor ocioso pueda revisar si debe retirarse)
+int buffer_get_timed(ProducerConsumerBuffer *buffer, int *items, long long *stamps,
+                     int max_items, int timeout_ms);
+
+// Items en el buffer ahora: producidos - consumidos - pisados
+int buffer_pending(ProducerConsumerBuffer *buffer);
+
+// Histogramas por consumidor: register crea y enlaza un par nuevo en el buffer;
+// snapshot combina los de todos los consumidores (llamar con ellos detenidos)
+ConsumerLatency *register_consumer_latency(ProducerConsumerBuffer *buffer);
+void buffer_latency_snapshot(ProducerConsumerBuffer *buffer,
+                             LatencyHistogram *queue_delay, LatencyHistogram *end_to_end);
+// Trabajo por defecto: item = thread_id * 1000 + número; consumir sólo lo traza
 int produce_item(int thread_id, int item_number);
 void consume_item(int item, int thread_id);
 
@@ -0,0 +1,328 @@
+#define _DEFAULT_SOURCE
+#include "trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+// Anillo de un hilo: head lo avanza sólo el hilo dueño, tail sólo quien
+// vacía (siempre con trace_lock tomado). Van en líneas de caché distintas
+// para que el escritor no invalide la del hilo que traza.
+typedef struct TraceRing {
+    _Alignas(64) atomic_size_t head;
+    atomic_llong dropped;              // Eventos descartados por anillo lleno
+    _Alignas(64) atomic_size_t tail;
+    struct TraceRing *next;            // Lista de todos los anillos (nunca se liberan)
+    struct TraceRing *next_free;       // Anillos de hilos terminados, para reutilizar
+    TraceRecord records[TRACE_RING_SIZE];
+} TraceRing;
+
+_Atomic int trace_level = TRACE_INFO;
+
+// Protege el registro de anillos, el vaciado y el estado del escritor
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ring_key;
+
+static TraceRing *all_rings = NULL;
+static TraceRing *free_rings = NULL;
+static atomic_llong orphan_dropped;    // Eventos de hilos sin anillo (sin memoria)
+static FILE *trace_out = NULL;         // NULL = stdout
+static long long trace_epoch = 0;     // Primer evento vaciado (0 = todavía ninguno)
+
+static pthread_t writer;
+static bool writer_running = false;
+static bool writer_stop = false;
+
+// Lote reutilizable donde se juntan los registros de todos los anillos
+static TraceRecord *batch = NULL;
+static size_t batch_capacity = 0;
+
+static _Thread_local TraceRing *my_ring = NULL;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Al terminar un hilo su anillo queda libre para el próximo; los registros
+// que tenga pendientes se siguen vaciando normalmente
+static void release_ring(void *arg) {
+    TraceRing *ring = (TraceRing *)arg;
+
+    pthread_mutex_lock(&trace_lock);
+    ring->next_free = free_rings;
+    free_rings = ring;
+    pthread_mutex_unlock(&trace_lock);
+}
+
+static void trace_init_once(void) {
+    pthread_key_create(&ring_key, release_ring);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&writer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static int compare_records(const void *a, const void *b) {
+    long long x = ((const TraceRecord *)a)->timestamp;
+    long long y = ((const TraceRecord *)b)->timestamp;
+    return (x > y) - (x < y);
+}
+
+static void format_record(FILE *out, const TraceRecord *r) {
+    fprintf(out, "[%10.3f ms] ", (r->timestamp - trace_epoch) / 1e6);
+
+    switch (r->event) {
+    case TRACE_PRODUCER_START:
+        fprintf(out, "Productor %d iniciado (producirá %d items)\n", r->thread_id, r->value);
+        break;
+    case TRACE_PRODUCER_END:
+        fprintf(out, "Productor %d terminado\n", r->thread_id);
+        break;
+    case TRACE_CONSUMER_START:
+        fprintf(out, "Consumidor %d iniciado\n", r->thread_id);
+        break;
+    case TRACE_CONSUMER_END:
+        fprintf(out, "Consumidor %d terminado\n", r->thread_id);
+        break;
+    case TRACE_ITEM_PUT:
+        fprintf(out, "Productor %d: item %d agregado en posición %d\n",
+                r->thread_id, r->value, r->slot);
+        break;
+    case TRACE_ITEM_GET:
+        fprintf(out, "Consumidor %d: item %d extraído de posición %d\n",
+                r->thread_id, r->value, r->slot);
+        break;
+    case TRACE_ITEM_CONSUMED:
+        fprintf(out, "Consumidor %d procesando item %d\n", r->thread_id, r->value);
+        break;
+    default:
+        fprintf(out, "Evento %d (hilo %d, valor %d)\n", r->event, r->thread_id, r->value);
+        break;
+    }
+}
+
+// Vaciar todos los anillos, ordenar por tiempo y formatear (con trace_lock)
+static void drain_locked(void) {
+    size_t count = 0;
+
+    for (TraceRing *ring = all_rings; ring; ring = ring->next) {
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t pending = head - tail;
+        if (pending == 0) continue;
+
+        if (count + pending > batch_capacity) {
+            size_t capacity = batch_capacity ? batch_capacity : TRACE_RING_SIZE;
+            while (capacity < count + pending) capacity *= 2;
+            TraceRecord *grown = realloc(batch, capacity * sizeof(TraceRecord));
+            if (!grown) continue;   // Se reintenta en el próximo vaciado
+            batch = grown;
+            batch_capacity = capacity;
+        }
+
+        for (size_t i = tail; i != head; i++) {
+            batch[count++] = ring->records[i & TRACE_RING_MASK];
+        }
+
+        // Liberar las posiciones para el hilo dueño
+        atomic_store_explicit(&ring->tail, head, memory_order_release);
+    }
+
+    if (count == 0) return;
+
+    qsort(batch, count, sizeof(TraceRecord), compare_records);
+    if (trace_epoch == 0) {
+        trace_epoch = batch[0].timestamp;
+    }
+
+    FILE *out = trace_out ? trace_out : stdout;
+    for (size_t i = 0; i < count; i++) {
+        format_record(out, &batch[i]);
+    }
+    fflush(out);
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&trace_lock);
+    while (!writer_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += TRACE_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&writer_cond, &trace_lock, &deadline);
+        drain_locked();
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return NULL;
+}
+
+// Primer evento de un hilo: tomar un anillo libre o crear uno, y arrancar
+// el escritor si todavía no corre
+static TraceRing *acquire_ring(void) {
+    static bool exit_hook = false;
+
+    pthread_once(&trace_once, trace_init_once);
+
+    pthread_mutex_lock(&trace_lock);
+
+    TraceRing *ring = free_rings;
+    if (ring) {
+        free_rings = ring->next_free;
+    } else {
+        ring = aligned_alloc(_Alignof(TraceRing), sizeof(TraceRing));
+        if (ring) {
+            atomic_init(&ring->head, 0);
+            atomic_init(&ring->tail, 0);
+            atomic_init(&ring->dropped, 0);
+            ring->next = all_rings;
+            all_rings = ring;
+        }
+    }
+
+    if (!writer_running && !writer_stop &&
+        pthread_create(&writer, NULL, writer_main, NULL) == 0) {
+        writer_running = true;
+        if (!exit_hook) {
+            atexit(trace_shutdown);
+            exit_hook = true;
+        }
+    }
+
+    pthread_mutex_unlock(&trace_lock);
+
+    if (ring) {
+        pthread_setspecific(ring_key, ring);
+        my_ring = ring;
+    }
+    return ring;
+}
+
+void trace_emit(TraceLevel level, TraceEvent event, int thread_id, int value, int slot) {
+    trace_emit_at(level, event, now_ns(), thread_id, value, slot);
+}
+
+void trace_emit_at(TraceLevel level, TraceEvent event, long long timestamp,
+                   int thread_id, int value, int slot) {
+    TraceRing *ring = my_ring ? my_ring : acquire_ring();
+    if (!ring) {
+        atomic_fetch_add_explicit(&orphan_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == TRACE_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TraceRecord *r = &ring->records[head & TRACE_RING_MASK];
+    r->timestamp = timestamp;
+    r->event = (short)event;
+    r->level = (short)level;
+    r->thread_id = thread_id;
+    r->value = value;
+    r->slot = slot;
+
+    // Publicar el registro al escritor
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void trace_set_level(TraceLevel level) {
+    atomic_store_explicit(&trace_level, level, memory_order_relaxed);
+}
+
+TraceLevel trace_get_level(void) {
+    return (TraceLevel)atomic_load_explicit(&trace_level, memory_order_relaxed);
+}
+
+void trace_init_from_env(void) {
+    const char *value = getenv("PC_TRACE");
+    if (!value) return;
+
+    if (strcasecmp(value, "off") == 0) {
+        trace_set_level(TRACE_OFF);
+    } else if (strcasecmp(value, "info") == 0) {
+        trace_set_level(TRACE_INFO);
+    } else if (strcasecmp(value, "debug") == 0) {
+        trace_set_level(TRACE_DEBUG);
+    } else {
+        fprintf(stderr, "PC_TRACE inválido (%s): use off, info o debug\n", value);
+    }
+}
+
+void trace_set_output(FILE *out) {
+    pthread_once(&trace_once, trace_init_once);
+
+    pthread_mutex_lock(&trace_lock);
+    drain_locked();
+    trace_out = out;
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_flush(void) {
+    pthread_once(&trace_once, trace_init_once);
+
+    pthread_mutex_lock(&trace_lock);
+    drain_locked();
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_shutdown(void) {
+    pthread_once(&trace_once, trace_init_once);
+
+    pthread_mutex_lock(&trace_lock);
+    writer_stop = true;
+    if (writer_running) {
+        pthread_cond_signal(&writer_cond);
+        pthread_mutex_unlock(&trace_lock);
+        pthread_join(writer, NULL);
+        pthread_mutex_lock(&trace_lock);
+        writer_running = false;
+    }
+    drain_locked();
+    pthread_mutex_unlock(&trace_lock);
+
+    long long dropped = trace_dropped();
+    if (dropped > 0) {
+        fprintf(stderr, "Trazas: %lld eventos descartados por anillos llenos\n", dropped);
+    }
+}
+
+long long trace_dropped(void) {
+    long long total = atomic_load_explicit(&orphan_dropped, memory_order_relaxed);
+
+    pthread_mutex_lock(&trace_lock);
+    for (TraceRing *ring = all_rings; ring; ring = ring->next) {
+        total += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    return total;
+}
+
+void trace_reset_dropped(void) {
+    atomic_store_explicit(&orphan_dropped, 0, memory_order_relaxed);
+
+    pthread_mutex_lock(&trace_lock);
+    for (TraceRing *ring = all_rings; ring; ring = ring->next) {
+        atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
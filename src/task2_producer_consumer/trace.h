@@ -0,0 +1,100 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Trazas asíncronas del producer-consumer. Cada hilo escribe registros
+// binarios de tamaño fijo en su propio anillo (un productor, un lector, sin
+// locks); un hilo escritor en segundo plano los vacía periódicamente, los
+// ordena por tiempo y recién ahí los formatea. Así ningún hilo de trabajo
+// toca stdio, y con el nivel apagado cada punto de traza cuesta una lectura
+// atómica relajada.
+#define TRACE_RING_SIZE 4096      // Registros por hilo (potencia de 2)
+#define TRACE_FLUSH_MS 20         // Período del escritor en segundo plano
+
+typedef enum {
+    TRACE_OFF = 0,                // Sin trazas (producción)
+    TRACE_INFO,                   // Inicio y fin de cada hilo
+    TRACE_DEBUG                   // Además, cada item que entra/sale del buffer
+} TraceLevel;
+
+typedef enum {
+    TRACE_PRODUCER_START,         // value = items a producir
+    TRACE_PRODUCER_END,
+    TRACE_CONSUMER_START,
+    TRACE_CONSUMER_END,
+    TRACE_ITEM_PUT,               // value = item, slot = posición
+    TRACE_ITEM_GET,               // value = item, slot = posición
+    TRACE_ITEM_CONSUMED           // value = item
+} TraceEvent;
+
+// Registro binario de un evento (24 bytes)
+typedef struct {
+    long long timestamp;          // ns, CLOCK_MONOTONIC
+    short event;                  // TraceEvent
+    short level;                  // TraceLevel
+    int thread_id;                // Id lógico del productor/consumidor
+    int value;
+    int slot;
+} TraceRecord;
+
+// Nivel actual; se lee en cada punto de traza
+extern _Atomic int trace_level;
+
+static inline bool trace_enabled(TraceLevel level) {
+    return level != TRACE_OFF &&
+           (int)level <= atomic_load_explicit(&trace_level, memory_order_relaxed);
+}
+
+// Punto de traza: sólo arma el registro si el nivel está activo
+#define TRACE(level, event, thread_id, value, slot)                       \
+    do {                                                                  \
+        if (trace_enabled(level)) {                                       \
+            trace_emit((level), (event), (thread_id), (value), (slot));   \
+        }                                                                 \
+    } while (0)
+
+// Igual que TRACE pero con un instante ya medido (ns, CLOCK_MONOTONIC), para
+// fechar el evento cuando ocurrió y no cuando se registró
+#define TRACE_AT(level, event, timestamp, thread_id, value, slot)                  \
+    do {                                                                           \
+        if (trace_enabled(level)) {                                                \
+            trace_emit_at((level), (event), (timestamp), (thread_id), (value), (slot)); \
+        }                                                                          \
+    } while (0)
+
+// Cambiar el nivel en cualquier momento, desde cualquier hilo
+void trace_set_level(TraceLevel level);
+TraceLevel trace_get_level(void);
+
+// Tomar el nivel de la variable de entorno PC_TRACE (off, info o debug);
+// sin la variable se mantiene el nivel actual (TRACE_INFO por defecto)
+void trace_init_from_env(void);
+
+// Destino del texto formateado (NULL = stdout); vacía lo pendiente antes
+void trace_set_output(FILE *out);
+
+// Encolar un evento en el anillo del hilo llamador. Si el anillo está lleno
+// el evento se descarta y se cuenta; nunca bloquea.
+void trace_emit(TraceLevel level, TraceEvent event, int thread_id, int value, int slot);
+void trace_emit_at(TraceLevel level, TraceEvent event, long long timestamp,
+                   int thread_id, int value, int slot);
+
+// Vaciar ahora todos los anillos al destino (p. ej. antes de imprimir
+// estadísticas, para que las trazas no se mezclen con ellas)
+void trace_flush(void);
+
+// Detener el escritor y vaciar lo pendiente; se registra con atexit()
+void trace_shutdown(void);
+
+// Eventos descartados por anillos llenos desde el inicio (o desde el último
+// trace_reset_dropped)
+long long trace_dropped(void);
+
+// Poner en cero los descartes, p. ej. tras una prueba que llena los anillos
+// a propósito, para que no se informen al salir
+void trace_reset_dropped(void);
+
+#endif // TRACE_H
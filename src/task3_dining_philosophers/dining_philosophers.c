@@ -1,5 +1,6 @@
 #define _DEFAULT_SOURCE
 #include "dining_philosophers.h"
+#include "../common/prng.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -7,8 +8,19 @@
 #include <errno.h>
 #include <string.h>
 
+// Mensajes de la simulación, omitidos en modo silencioso (p. ej. en benchmarks)
+#define TABLE_LOG(table, ...) do { if ((table)->verbose) printf(__VA_ARGS__); } while (0)
+
+// Flujo del PRNG de cada filósofo: con la misma semilla maestra repite sus tiempos
+#define PHIL_PRNG_STREAM 3
+
 // Inicializar la mesa de comedor
 int init_dining_table(DiningTable *table) {
+    return init_dining_table_ex(table, true);
+}
+
+// Igual, eligiendo desde el inicio si se imprimen los eventos (benchmarks: false)
+int init_dining_table_ex(DiningTable *table, bool verbose) {
     if (!table) {
         fprintf(stderr, "Error: Table es NULL\n");
         return -1;
@@ -86,8 +98,12 @@ int init_dining_table(DiningTable *table) {
 
     table->simulation_running = true;
     table->total_meals_served = 0;
+    table->verbose = verbose;
+    table->thinking_time_ms = THINKING_TIME_MS;
+    table->eating_time_ms = EATING_TIME_MS;
 
-    printf("Mesa de comedor inicializada correctamente con %d filósofos\n", NUM_PHILOSOPHERS);
+    TABLE_LOG(table, "Mesa de comedor inicializada correctamente con %d filósofos\n",
+              NUM_PHILOSOPHERS);
     return 0;
 }
 
@@ -112,7 +128,7 @@ void destroy_dining_table(DiningTable *table) {
         pthread_mutex_destroy(&table->forks[i]);
     }
 
-    printf("Mesa de comedor destruida correctamente\n");
+    TABLE_LOG(table, "Mesa de comedor destruida correctamente\n");
 }
 
 // Función principal del filósofo
@@ -121,7 +137,8 @@ void *philosopher_life(void *arg) {
     DiningTable *table = (DiningTable *)((char *)phil - 
         phil->id * sizeof(Philosopher));
 
-    printf("🧠 Filósofo %d comenzó a pensar\n", phil->id);
+    prng_thread_seed(PRNG_STREAM(PHIL_PRNG_STREAM, phil->id));
+    TABLE_LOG(table, "🧠 Filósofo %d comenzó a pensar\n", phil->id);
 
     while (table->simulation_running && phil->eating_count < MAX_EATING_CYCLES) {
         // Pensar
@@ -133,7 +150,7 @@ void *philosopher_life(void *arg) {
         semaphore_solution(phil, table);
     }
 
-    printf("🏁 Filósofo %d terminó (comió %d veces)\n", phil->id, phil->eating_count);
+    TABLE_LOG(table, "🏁 Filósofo %d terminó (comió %d veces)\n", phil->id, phil->eating_count);
     return NULL;
 }
 
@@ -143,10 +160,14 @@ void think(Philosopher *phil, DiningTable *table) {
     phil->state = THINKING;
     pthread_mutex_unlock(&table->state_mutex);
 
-    printf("🤔 Filósofo %d está pensando\n", phil->id);
+    TABLE_LOG(table, "🤔 Filósofo %d está pensando\n", phil->id);
     
-    int thinking_time = THINKING_TIME_MS + (rand() % THINKING_TIME_MS);
-    usleep(thinking_time * 1000);
+    int thinking_time = 0;
+    if (table->thinking_time_ms > 0) {
+        thinking_time = table->thinking_time_ms +
+                        (int)prng_thread_below((uint32_t)table->thinking_time_ms);
+        usleep(thinking_time * 1000);
+    }
     
     phil->total_thinking_time += thinking_time;
 }
@@ -156,7 +177,7 @@ void pickup_forks(Philosopher *phil, DiningTable *table) {
     pthread_mutex_lock(&table->state_mutex);
     
     phil->state = HUNGRY;
-    printf("😋 Filósofo %d tiene hambre\n", phil->id);
+    TABLE_LOG(table, "😋 Filósofo %d tiene hambre\n", phil->id);
     
     test_philosopher(phil->id, table);
     
@@ -169,11 +190,15 @@ void pickup_forks(Philosopher *phil, DiningTable *table) {
 
 // Función de comer
 void eat(Philosopher *phil, DiningTable *table) {
-    printf("🍽️  Filósofo %d está comiendo (comida #%d)\n", 
-           phil->id, phil->eating_count + 1);
+    TABLE_LOG(table, "🍽️  Filósofo %d está comiendo (comida #%d)\n", 
+              phil->id, phil->eating_count + 1);
     
-    int eating_time = EATING_TIME_MS + (rand() % EATING_TIME_MS);
-    usleep(eating_time * 1000);
+    int eating_time = 0;
+    if (table->eating_time_ms > 0) {
+        eating_time = table->eating_time_ms +
+                      (int)prng_thread_below((uint32_t)table->eating_time_ms);
+        usleep(eating_time * 1000);
+    }
     
     phil->eating_count++;
     phil->total_eating_time += eating_time;
@@ -188,7 +213,7 @@ void putdown_forks(Philosopher *phil, DiningTable *table) {
     pthread_mutex_lock(&table->state_mutex);
     
     phil->state = THINKING;
-    printf("✅ Filósofo %d dejó los tenedores\n", phil->id);
+    TABLE_LOG(table, "✅ Filósofo %d dejó los tenedores\n", phil->id);
     
     // Permitir que los vecinos intenten comer
     test_philosopher(left_fork(phil->id), table);
@@ -207,7 +232,7 @@ void test_philosopher(int phil_id, DiningTable *table) {
         table->philosophers[right].state != EATING) {
         
         table->philosophers[phil_id].state = EATING;
-        printf("🎉 Filósofo %d puede comer ahora\n", phil_id);
+        TABLE_LOG(table, "🎉 Filósofo %d puede comer ahora\n", phil_id);
         pthread_cond_signal(&table->condition[phil_id]);
     }
 }
@@ -37,10 +37,14 @@ typedef struct {
     bool simulation_running;
     int total_meals_served;
     pthread_mutex_t stats_mutex;
+    bool verbose;                              // Imprimir cada evento (false en benchmarks)
+    int thinking_time_ms;                      // Tiempo base de pensar (0 = sin espera)
+    int eating_time_ms;                        // Tiempo base de comer (0 = sin espera)
 } DiningTable;
 
 // Funciones principales
 int init_dining_table(DiningTable *table);
+int init_dining_table_ex(DiningTable *table, bool verbose);
 void destroy_dining_table(DiningTable *table);
 void *philosopher_life(void *arg);
 
@@ -0,0 +1,119 @@
+#define _DEFAULT_SOURCE
+#include "dining_philosophers.h"
+#include "../bench/bench_harness.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Benchmark de la mesa de filósofos: tiempos de pensar/comer en cero y sin
+// mensajes, para medir sólo el costo de sincronización. Se varía el número de
+// filósofos activos (los demás asientos quedan vacíos). La latencia es la
+// duración de una comida completa (tomar tenedores, comer, soltarlos).
+
+#define PHIL_BENCH_MEALS 4000   // Comidas por filósofo y repetición
+
+typedef void (*SolutionFn)(Philosopher *phil, DiningTable *table);
+
+typedef struct {
+    DiningTable *table;
+    Philosopher *phil;
+    SolutionFn solution;
+    int meals;
+    BenchSamples samples;
+} PhilWorker;
+
+typedef struct {
+    DiningTable table;
+    SolutionFn solution;
+    int active;    // Filósofos que compiten por los tenedores
+    int meals;
+} PhilCase;
+
+static void *bench_philosopher(void *arg) {
+    PhilWorker *w = (PhilWorker *)arg;
+
+    for (int i = 0; i < w->meals; i++) {
+        long long start = bench_now_ns();
+        w->solution(w->phil, w->table);
+        bench_samples_add(&w->samples, bench_now_ns() - start);
+    }
+
+    return NULL;
+}
+
+static int philosophers_run(void *ctx, BenchRun *run) {
+    PhilCase *pc = (PhilCase *)ctx;
+    PhilWorker workers[NUM_PHILOSOPHERS];
+    pthread_t threads[NUM_PHILOSOPHERS];
+
+    long long start = bench_now_ns();
+    for (int i = 0; i < pc->active; i++) {
+        workers[i].table = &pc->table;
+        workers[i].phil = &pc->table.philosophers[i];
+        workers[i].solution = pc->solution;
+        workers[i].meals = pc->meals;
+        bench_samples_init(&workers[i].samples);
+        pthread_create(&threads[i], NULL, bench_philosopher, &workers[i]);
+    }
+    for (int i = 0; i < pc->active; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    run->seconds = (bench_now_ns() - start) / 1e9;
+    run->ops = (long long)pc->meals * pc->active;
+
+    for (int i = 0; i < pc->active; i++) {
+        bench_samples_append(run->samples, &workers[i].samples);
+        bench_samples_free(&workers[i].samples);
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config;
+    if (bench_parse_args(&config, argc, argv) != 0) {
+        return 1;
+    }
+
+    printf("Benchmark Filósofos Cenando\n");
+    printf("===========================\n");
+
+    static const char *names[] = {"semaphore", "asymmetric"};
+    static const SolutionFn solutions[] = {semaphore_solution, asymmetric_solution};
+
+    // Una mesa por solución, inicializada antes de imprimir la tabla
+    PhilCase cases[2];
+    for (int s = 0; s < 2; s++) {
+        if (init_dining_table_ex(&cases[s].table, false) != 0) {
+            return 1;
+        }
+        cases[s].table.thinking_time_ms = 0;
+        cases[s].table.eating_time_ms = 0;
+        cases[s].solution = solutions[s];
+        cases[s].meals = config.quick ? PHIL_BENCH_MEALS / 10 : PHIL_BENCH_MEALS;
+    }
+
+    BenchReport report;
+    bench_report_init(&report, "philosophers", &config);
+
+    int result = 0;
+    for (int s = 0; s < 2 && result == 0; s++) {
+        for (int active = 1; active <= NUM_PHILOSOPHERS && result == 0; active++) {
+            // En modo rápido sólo los extremos: sin competencia y mesa llena
+            if (config.quick && active != 1 && active != NUM_PHILOSOPHERS) continue;
+
+            cases[s].active = active;
+            BenchCase bc = {names[s], active, NUM_PHILOSOPHERS, 0};
+            result = bench_run(&report, &bc, philosophers_run, &cases[s]);
+        }
+    }
+
+    if (bench_report_finish(&report) != 0) {
+        result = -1;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        destroy_dining_table(&cases[s].table);
+    }
+
+    return result == 0 ? 0 : 1;
+}
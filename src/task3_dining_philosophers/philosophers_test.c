@@ -1,5 +1,6 @@
 #define _DEFAULT_SOURCE
 #include "dining_philosophers.h"
+#include "../common/prng.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -308,8 +309,8 @@ int main() {
     printf("  - Condition variables para sincronización\n");
     printf("  - Mutexes para exclusión mutua\n\n");
     
-    // Configurar semilla para números aleatorios
-    srand(time(NULL));
+    // Semilla maestra del PRNG por hilo; LAB_SEED=<semilla> repite los tiempos
+    printf("Semilla: %llu\n", (unsigned long long)prng_init_from_env());
     
     // Configurar manejador de señales
     signal(SIGINT, signal_handler);